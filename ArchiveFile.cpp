@@ -0,0 +1,238 @@
+/*
+ * ArchiveFile.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "ArchiveFile.h"
+
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+
+const string_view AR_MAGIC = "!<arch>\n";
+const size_t HEADER_SIZE = 60;
+const size_t SIZE_FIELD_OFFSET = 48;
+const size_t SIZE_FIELD_LEN = 10;
+
+string_view TrimRight(string_view s)
+{
+    auto end = s.find_last_not_of(' ');
+    return end == string_view::npos ? string_view() : s.substr(0, end + 1);
+}
+
+uint64_t ReadNumber(string_view s)
+{
+    s = TrimRight(s);
+    uint64_t n = 0;
+    if (s.empty())
+        throw runtime_error("Invalid number in archive member header");
+    for (char c: s)
+    {
+        if (!isdigit(static_cast<unsigned char>(c)))
+            throw runtime_error("Invalid number in archive member header");
+        n = n * 10 + (c - '0');
+    }
+    return n;
+}
+
+uint64_t ReadBigEndian(string_view data, size_t offset, size_t width)
+{
+    if (offset + width > data.size())
+        throw runtime_error("Truncated archive symbol index");
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; ++i)
+        v = (v << 8) | static_cast<unsigned char>(data[offset + i]);
+    return v;
+}
+
+void WriteBigEndian(string &out, uint64_t v, size_t width)
+{
+    for (size_t i = width; i > 0; --i)
+        out += static_cast<char>((v >> ((i - 1) * 8)) & 0xFF);
+}
+
+}  // namespace
+
+
+ArchiveFile::ArchiveFile(std::string contents)
+{
+    if (!IsArchive(contents))
+        throw runtime_error("Not a supported archive file");
+
+    string_view ar(contents);
+    string_view long_names;
+    string_view index_data;
+    map<uint64_t, size_t> member_at;
+
+    size_t pos = AR_MAGIC.size();
+    while (pos < ar.size())
+    {
+        if (ar[pos] == '\n') // tolerate extra padding
+        {
+            ++pos;
+            continue;
+        }
+        if (ar.size() - pos < HEADER_SIZE || ar.substr(pos + 58, 2) != "`\n")
+            throw runtime_error("Corrupted archive member header");
+
+        Member m;
+        m.header = string(ar.substr(pos, HEADER_SIZE));
+        uint64_t size = ReadNumber(ar.substr(pos + SIZE_FIELD_OFFSET,
+            SIZE_FIELD_LEN));
+        if (ar.size() - pos - HEADER_SIZE < size)
+            throw runtime_error("Truncated archive member");
+        m.data = string(ar.substr(pos + HEADER_SIZE, size));
+
+        string_view raw_name = TrimRight(ar.substr(pos, 16));
+        if (raw_name == "/" || raw_name == "/SYM64/")
+        {
+            m.special = true;
+            index_member = members.size();
+            index64 = raw_name != "/";
+            index_data = ar.substr(pos + HEADER_SIZE, size);
+        }
+        else if (raw_name == "//")
+        {
+            m.special = true;
+            long_names = ar.substr(pos + HEADER_SIZE, size);
+        }
+        else if (raw_name.substr(0, 9) == "__.SYMDEF")
+            throw runtime_error("BSD archive symbol index is not supported");
+        else if (raw_name.substr(0, 3) == "#1/")
+        {
+            m.bsd_name_len = ReadNumber(raw_name.substr(3));
+            if (m.bsd_name_len > m.data.size())
+                throw runtime_error("Invalid archive member name");
+            m.name = m.data.substr(0, m.bsd_name_len);
+            m.name.erase(m.name.find_last_not_of('\0') + 1);
+        }
+        else if (raw_name.size() > 1 && raw_name[0] == '/')
+        {
+            auto offset = ReadNumber(raw_name.substr(1));
+            if (offset >= long_names.size())
+                throw runtime_error("Invalid archive long member name");
+            auto name = long_names.substr(offset);
+            name = name.substr(0, name.find('\n'));
+            if (!name.empty() && name.back() == '/')
+                name.remove_suffix(1);
+            m.name = string(name);
+        }
+        else
+        {
+            if (!raw_name.empty() && raw_name.back() == '/')
+                raw_name.remove_suffix(1);
+            m.name = string(raw_name);
+        }
+
+        member_at[pos] = members.size();
+        members.push_back(move(m));
+        pos += HEADER_SIZE + size + (size & 1);
+    }
+
+    if (index_member >= 0)
+    {
+        const size_t w = index64 ? 8 : 4;
+        auto count = ReadBigEndian(index_data, 0, w);
+        size_t names_pos = w + count * w;
+        if (count > index_data.size() || names_pos > index_data.size())
+            throw runtime_error("Corrupted archive symbol index");
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            auto offset = ReadBigEndian(index_data, w + i * w, w);
+            auto name_end = index_data.find('\0', names_pos);
+            if (name_end == string_view::npos)
+                throw runtime_error("Corrupted archive symbol index");
+            auto m = member_at.find(offset);
+            if (m == member_at.end())
+                throw runtime_error("Archive symbol index refers to an "
+                        "invalid member");
+            index.push_back(IndexEntry { string(index_data.substr(names_pos,
+                name_end - names_pos)), m->second });
+            names_pos = name_end + 1;
+        }
+    }
+}
+
+bool ArchiveFile::IsArchive(std::string_view data)
+{
+    return data.substr(0, AR_MAGIC.size()) == AR_MAGIC;
+}
+
+void ArchiveFile::SetContents(Member &member, std::string contents)
+{
+    member.data.resize(member.bsd_name_len);
+    member.data += contents;
+}
+
+void ArchiveFile::RenameIndexSymbols(const ElfFile::RenameMap &renames)
+{
+    for (auto &entry: index)
+    {
+        auto r = renames.find(entry.symbol);
+        if (r != renames.end())
+            entry.symbol = r->second;
+    }
+}
+
+std::string ArchiveFile::Serialize() const
+{
+    const size_t w = index64 ? 8 : 4;
+    size_t index_size = w + index.size() * w;
+    for (const auto &entry: index)
+        index_size += entry.symbol.size() + 1;
+
+    vector<uint64_t> offsets(members.size());
+    uint64_t pos = AR_MAGIC.size();
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        offsets[i] = pos;
+        size_t size = long(i) == index_member ? index_size
+                : members[i].data.size();
+        pos += HEADER_SIZE + size + (size & 1);
+    }
+
+    string out(AR_MAGIC);
+    out.reserve(pos);
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        string data;
+        if (long(i) == index_member)
+        {
+            WriteBigEndian(data, index.size(), w);
+            for (const auto &entry: index)
+                WriteBigEndian(data, offsets[entry.member], w);
+            for (const auto &entry: index)
+            {
+                data += entry.symbol;
+                data += '\0';
+            }
+        }
+        const string &contents = long(i) == index_member ? data
+                : members[i].data;
+
+        char size_field[SIZE_FIELD_LEN + 1];
+        snprintf(size_field, sizeof(size_field), "%-10zu", contents.size());
+        string header = members[i].header;
+        header.replace(SIZE_FIELD_OFFSET, SIZE_FIELD_LEN, size_field,
+            SIZE_FIELD_LEN);
+
+        out += header;
+        out += contents;
+        if (contents.size() & 1)
+            out += '\n';
+    }
+    return out;
+}
@@ -0,0 +1,96 @@
+/*
+ * ArchiveFile.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef ARCHIVEFILE_H_
+#define ARCHIVEFILE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ElfFile.h"
+
+/**
+ * An in-memory static library (ar archive) in GNU/SysV format. Members can be
+ * modified and the archive can be serialized again; the archive symbol index
+ * is updated accordingly.
+ */
+class ArchiveFile
+{
+    public:
+        struct Member
+        {
+            /// resolved name of the member
+            std::string name;
+            /// raw member header, the size field is updated when serializing
+            std::string header;
+            std::string data;
+            /// length of BSD style member name stored at the start of data
+            size_t bsd_name_len = 0;
+            /// archive symbol index or long names table
+            bool special = false;
+
+            std::string_view Contents() const
+            {
+                return std::string_view(data).substr(bsd_name_len);
+            }
+        };
+
+    public:
+        /**
+         * @param contents contents of an archive file
+         * @throw std::runtime_error if @p contents is not a supported archive
+         */
+        explicit ArchiveFile(std::string contents);
+
+        /**
+         * @return true if @p data looks like an archive which can be handled
+         * by this class (thin archives are not supported)
+         */
+        static bool IsArchive(std::string_view data);
+
+        /**
+         * @return all members, including special ones (check Member::special)
+         */
+        std::vector<Member> &Members() { return members; }
+        const std::vector<Member> &Members() const { return members; }
+
+        /**
+         * Replace the contents of @p member with @p contents
+         */
+        void SetContents(Member &member, std::string contents);
+
+        /**
+         * Rename symbols in the archive symbol index
+         */
+        void RenameIndexSymbols(const ElfFile::RenameMap &renames);
+
+        /**
+         * @return the archive file contents
+         */
+        std::string Serialize() const;
+
+    private:
+        struct IndexEntry
+        {
+            std::string symbol;
+            size_t member;
+        };
+
+        std::vector<Member> members;
+        std::vector<IndexEntry> index;
+        /// index of the archive symbol table member, or -1 if none
+        long index_member = -1;
+        bool index64 = false;
+};
+
+#endif /* ARCHIVEFILE_H_ */
@@ -0,0 +1,124 @@
+/*
+ * BindCache.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "BindCache.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "FileUtils.h"
+
+using namespace std;
+using PowerFake::internal::WrapperBase;
+
+namespace
+{
+const char CACHE_MAGIC[] = "powerfake-bind-cache 1";
+}
+
+
+uint64_t BindCache::PrototypesHash(const WrapperBase::Prototypes &protos)
+{
+    uint64_t hash = ContentHash("");
+    for (const auto &p: protos)
+    {
+        hash = ContentHash(p.second.alias, hash);
+        hash = ContentHash(p.second.Str() + '\n', hash);
+    }
+    return hash;
+}
+
+bool BindCache::Load(const std::string &file_name)
+{
+    ifstream in(file_name);
+    string line;
+    if (!getline(in, line) || line != CACHE_MAGIC)
+        return false;
+
+    *this = BindCache();
+    while (getline(in, line))
+    {
+        istringstream fields(line);
+        string type;
+        fields >> type;
+        if (type == "key")
+        {
+            fields >> key.base_hash >> key.prototypes_hash;
+            fields.ignore(1);
+            getline(fields, key.options);
+        }
+        else if (type == "symbol")
+        {
+            string alias, symbol;
+            fields >> alias >> symbol;
+            symbol_map[alias] = symbol;
+        }
+        else if (type == "flag")
+            link_flags += line.substr(type.size() + 1) + '\n';
+        else if (type == "object")
+        {
+            ObjectEntry obj;
+            fields >> obj.input_hash >> obj.output_hash;
+            fields.ignore(1);
+            getline(fields, obj.file_name);
+            objects.push_back(obj);
+        }
+        else if (type == "rename" && !objects.empty())
+        {
+            string from, to;
+            fields >> from >> to;
+            objects.back().renames[from] = to;
+        }
+        else
+            return false;
+        if (fields.fail())
+            return false;
+    }
+    return true;
+}
+
+void BindCache::Save(const std::string &file_name) const
+{
+    ostringstream out;
+    out << CACHE_MAGIC << '\n';
+    out << "key " << key.base_hash << ' ' << key.prototypes_hash << ' '
+            << key.options << '\n';
+    for (const auto &sym: symbol_map)
+        out << "symbol " << sym.first << ' ' << sym.second << '\n';
+    istringstream flags(link_flags);
+    string flag;
+    while (getline(flags, flag))
+        out << "flag " << flag << '\n';
+    for (const auto &obj: objects)
+    {
+        out << "object " << obj.input_hash << ' ' << obj.output_hash << ' '
+                << obj.file_name << '\n';
+        for (const auto &r: obj.renames)
+            out << "rename " << r.first << ' ' << r.second << '\n';
+    }
+    WriteFileAtomically(file_name, out.str());
+}
+
+bool BindCache::Matches(const Key &key, const vector<string> &objfiles,
+    const vector<uint64_t> &object_hashes) const
+{
+    if (!(this->key == key) || objects.size() != objfiles.size())
+        return false;
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (objects[i].file_name != objfiles[i]
+                || (objects[i].input_hash != object_hashes[i]
+                    && objects[i].output_hash != object_hashes[i]))
+            return false;
+    }
+    return true;
+}
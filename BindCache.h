@@ -0,0 +1,86 @@
+/*
+ * BindCache.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef BINDCACHE_H_
+#define BINDCACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ElfFile.h"
+#include "SymbolAliasMap.h"
+
+/**
+ * Results of a bind_fakes run, keyed by content hashes of its inputs, so that
+ * a later run with the same inputs can replay them without scanning the base
+ * library and wrapper objects again.
+ */
+class BindCache
+{
+    public:
+        struct ObjectEntry
+        {
+            std::string file_name;
+            /// content hash before renaming symbols
+            uint64_t input_hash;
+            /// content hash after renaming symbols
+            uint64_t output_hash;
+            ElfFile::RenameMap renames;
+        };
+
+        struct Key
+        {
+            std::string options;
+            uint64_t base_hash;
+            uint64_t prototypes_hash;
+
+            bool operator==(const Key &o) const
+            {
+                return options == o.options && base_hash == o.base_hash
+                        && prototypes_hash == o.prototypes_hash;
+            }
+        };
+
+    public:
+        /**
+         * @return hash of all wrapped function prototypes
+         */
+        static uint64_t PrototypesHash(
+            const PowerFake::internal::WrapperBase::Prototypes &protos);
+
+        /**
+         * Loads cache from @p file_name
+         * @return false if the file does not exist or is invalid
+         */
+        bool Load(const std::string &file_name);
+
+        /**
+         * Saves the cache into @p file_name atomically
+         */
+        void Save(const std::string &file_name) const;
+
+        /**
+         * @return true if cached results can be used for the given key and
+         * object files with the given content hashes, i.e. each object is
+         * either unchanged since the cached run or it is the output of it
+         */
+        bool Matches(const Key &key, const std::vector<std::string> &objfiles,
+            const std::vector<uint64_t> &object_hashes) const;
+
+        Key key;
+        SymbolAliasMap::MapType symbol_map;
+        std::string link_flags;
+        std::vector<ObjectEntry> objects;
+};
+
+#endif /* BINDCACHE_H_ */
@@ -0,0 +1,112 @@
+/*
+ * BindStats.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "BindStats.h"
+
+#include <cstdio>
+#include <time.h>
+
+using namespace std;
+
+namespace
+{
+
+const char *const phase_names[] = { "read", "demangle", "match", "rename",
+    "link_flags", "total" };
+
+double Now(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+}  // namespace
+
+
+void BindStats::Timer::Start()
+{
+    wall_start = Now(CLOCK_MONOTONIC);
+    cpu_start = Now(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void BindStats::Timer::Stop()
+{
+    wall += Now(CLOCK_MONOTONIC) - wall_start;
+    cpu += Now(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+}
+
+BindStats::ScopedPhase::ScopedPhase(BindStats *stats, Phase phase,
+    uint64_t items) :
+        stats(stats), phase(phase), items(items)
+{
+    if (stats)
+        timer.Start();
+}
+
+BindStats::ScopedPhase::~ScopedPhase()
+{
+    if (!stats)
+        return;
+    timer.Stop();
+    stats->Add(phase, timer, items);
+}
+
+void BindStats::Add(Phase phase, const Timer &timer, uint64_t items)
+{
+    lock_guard<std::mutex> lock(mutex);
+    phases[phase].wall += timer.wall;
+    phases[phase].cpu += timer.cpu;
+    phases[phase].items += items;
+}
+
+void BindStats::Report(std::ostream &out) const
+{
+    lock_guard<std::mutex> lock(mutex);
+    char line[100];
+    out << "bind_fakes statistics" << (cached ? " (cached results)" : "")
+            << ":\n";
+    snprintf(line, sizeof(line), "  %-12s %10s %10s %12s\n", "phase",
+        "wall(s)", "cpu(s)", "items");
+    out << line;
+    for (int p = 0; p < PHASE_COUNT; ++p)
+    {
+        snprintf(line, sizeof(line), "  %-12s %10.3f %10.3f %12llu\n",
+            phase_names[p], phases[p].wall, phases[p].cpu,
+            static_cast<unsigned long long>(phases[p].items));
+        out << line;
+    }
+    out << "  symbols: " << symbols << ", candidates: " << candidates
+            << ", matched: " << matched << '\n'
+            << "  wrapper objects: " << wrapper_objects
+            << ", wrapper symbols: " << wrapper_symbols
+            << ", spawned processes: " << processes << '\n';
+}
+
+void BindStats::WriteJson(std::ostream &out) const
+{
+    lock_guard<std::mutex> lock(mutex);
+    out << "{\n  \"cached\": " << (cached ? "true" : "false")
+            << ",\n  \"phases\": {\n";
+    for (int p = 0; p < PHASE_COUNT; ++p)
+        out << "    \"" << phase_names[p] << "\": { \"wall\": "
+                << phases[p].wall << ", \"cpu\": " << phases[p].cpu
+                << ", \"items\": " << phases[p].items << " }"
+                << (p + 1 < PHASE_COUNT ? ",\n" : "\n");
+    out << "  },\n"
+            << "  \"symbols\": " << symbols << ",\n"
+            << "  \"candidates\": " << candidates << ",\n"
+            << "  \"matched\": " << matched << ",\n"
+            << "  \"wrapper_objects\": " << wrapper_objects << ",\n"
+            << "  \"wrapper_symbols\": " << wrapper_symbols << ",\n"
+            << "  \"processes\": " << processes << "\n}\n";
+}
@@ -0,0 +1,111 @@
+/*
+ * BindStats.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef BINDSTATS_H_
+#define BINDSTATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+/**
+ * Collects timing and counters of bind_fakes phases
+ */
+class BindStats
+{
+    public:
+        enum Phase
+        {
+            READ,       ///< reading symbols of base libraries
+            DEMANGLE,   ///< filtering and demangling symbols
+            MATCH,      ///< matching symbols with wrapped functions
+            RENAME,     ///< finding & renaming symbols of wrapper objects
+            LINK_FLAGS, ///< writing link flags
+            TOTAL,
+            PHASE_COUNT
+        };
+
+        struct PhaseStats
+        {
+            double wall = 0;
+            double cpu = 0;
+            uint64_t items = 0;
+        };
+
+        /**
+         * Measures wall and CPU time of the current thread. Can be started and
+         * stopped several times to accumulate the time of interleaved phases.
+         */
+        class Timer
+        {
+            public:
+                void Start();
+                void Stop();
+
+                double wall = 0;
+                double cpu = 0;
+
+            private:
+                double wall_start = 0;
+                double cpu_start = 0;
+        };
+
+        /**
+         * Starts a timer on construction, and adds the measured time to the
+         * given phase on destruction. Does nothing if stats is nullptr.
+         */
+        class ScopedPhase
+        {
+            public:
+                ScopedPhase(BindStats *stats, Phase phase, uint64_t items = 0);
+                ~ScopedPhase();
+
+            private:
+                BindStats *stats;
+                Phase phase;
+                uint64_t items;
+                Timer timer;
+        };
+
+    public:
+        /**
+         * Adds time of a phase, might be called from multiple threads
+         */
+        void Add(Phase phase, const Timer &timer, uint64_t items = 0);
+
+        const PhaseStats &Get(Phase phase) const { return phases[phase]; }
+
+        /**
+         * Prints a human readable report
+         */
+        void Report(std::ostream &out) const;
+
+        /**
+         * Writes stats in JSON format
+         */
+        void WriteJson(std::ostream &out) const;
+
+        std::atomic<uint64_t> symbols { 0 };
+        std::atomic<uint64_t> candidates { 0 };
+        std::atomic<uint64_t> matched { 0 };
+        std::atomic<uint64_t> wrapper_symbols { 0 };
+        std::atomic<uint64_t> wrapper_objects { 0 };
+        std::atomic<uint64_t> processes { 0 };
+        bool cached = false;
+
+    private:
+        PhaseStats phases[PHASE_COUNT];
+        mutable std::mutex mutex;
+};
+
+#endif /* BINDSTATS_H_ */
@@ -0,0 +1,111 @@
+/*
+ * CallSiteAnalysis.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "CallSiteAnalysis.h"
+
+#include <elf.h>
+#include <boost/core/demangle.hpp>
+
+#include "ArchiveFile.h"
+#include "ElfFile.h"
+#include "FileUtils.h"
+
+using namespace std;
+
+
+CallSiteAnalysis::CallSiteAnalysis(
+    const std::map<std::string, std::string> &symbols)
+{
+    for (const auto &sym: symbols)
+        infos[sym.second];
+}
+
+bool CallSiteAnalysis::AddFile(const std::string &file_name)
+{
+    string contents = ReadFile(file_name);
+    if (ArchiveFile::IsArchive(contents))
+    {
+        ArchiveFile archive(move(contents));
+        for (const auto &member: archive.Members())
+            if (!member.special && ElfFile::IsSupported(member.Contents()))
+                AddObject(ElfFile(string(member.Contents())));
+        return true;
+    }
+    if (!ElfFile::IsSupported(contents) || ElfFile::IsSharedObject(contents))
+        return false;
+    AddObject(ElfFile(move(contents)));
+    return true;
+}
+
+void CallSiteAnalysis::AddObject(const ElfFile &elf)
+{
+    for (const auto &sym: elf.Symbols())
+    {
+        if (sym.shndx == SHN_UNDEF || sym.shndx == SHN_COMMON)
+            continue;
+        auto info = infos.find(sym.name);
+        if (info == infos.end())
+            continue;
+        if (sym.bind == STB_LOCAL)
+            ++info->second.local_defs;
+        else if (sym.bind == STB_WEAK)
+            ++info->second.weak_defs;
+        else
+            ++info->second.global_defs;
+    }
+
+    for (const auto &ref: elf.References())
+    {
+        auto info = infos.find(ref.symbol);
+        if (info == infos.end())
+            continue;
+        if (ref.defined)
+            ++info->second.unwrapped_refs;
+        else
+            ++info->second.wrapped_refs;
+        if (ref.from_code)
+            ++info->second.code_refs;
+    }
+}
+
+std::set<std::string> CallSiteAnalysis::Unreferenced() const
+{
+    set<string> unreferenced;
+    for (const auto &i: infos)
+        if (!i.second.wrapped_refs)
+            unreferenced.insert(i.first);
+    return unreferenced;
+}
+
+void CallSiteAnalysis::Report(std::ostream &out) const
+{
+    for (const auto &i: infos)
+    {
+        const auto &info = i.second;
+        out << "Call sites of " << boost::core::demangle(i.first.c_str())
+                << ": " << info.wrapped_refs << " wrapped, "
+                << info.unwrapped_refs << " not wrapped (" << info.code_refs
+                << " from code); definitions: " << info.global_defs
+                << " global, " << info.weak_defs << " weak, "
+                << info.local_defs << " local\n";
+        if (info.unwrapped_refs)
+            out << "\tReferences from its own object file cannot be faked\n";
+        if (info.local_defs)
+            out << "\tStatic functions with the same name cannot be faked\n";
+        if (!info.wrapped_refs && !info.unwrapped_refs)
+            out << "\tNo references found: calls might be inlined, only calls "
+                    "from outside of the analyzed libraries can be faked\n";
+        else if (info.weak_defs)
+            out << "\tInline or template function: inlined calls cannot be "
+                    "faked\n";
+    }
+}
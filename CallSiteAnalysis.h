@@ -0,0 +1,93 @@
+/*
+ * CallSiteAnalysis.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef CALLSITEANALYSIS_H_
+#define CALLSITEANALYSIS_H_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <string_view>
+
+class ElfFile;
+
+/**
+ * Finds how wrapped symbols are referenced inside object files using their
+ * relocations. GNU ld's --wrap only redirects undefined references, so calls
+ * from the object defining a function are not wrapped, and inlined calls have
+ * no reference at all.
+ */
+class CallSiteAnalysis
+{
+    public:
+        struct SymbolInfo
+        {
+            /// references from objects not defining the symbol, which are
+            /// redirected by --wrap
+            size_t wrapped_refs = 0;
+            /// references from objects defining the symbol, not wrapped
+            size_t unwrapped_refs = 0;
+            /// references from executable code, i.e. mostly calls
+            size_t code_refs = 0;
+            size_t global_defs = 0;
+            /// e.g. inline functions and template instances
+            size_t weak_defs = 0;
+            /// local (static) symbols with the same name
+            size_t local_defs = 0;
+        };
+
+        typedef std::map<std::string, SymbolInfo, std::less<>> InfoMap;
+
+    public:
+        /**
+         * @param symbols maps aliases to wrapped symbols, e.g.
+         * SymbolAliasMap::Map()
+         */
+        explicit CallSiteAnalysis(
+            const std::map<std::string, std::string> &symbols);
+
+        /**
+         * Analyzes @p file_name if it is an object file or a static library.
+         * Shared objects are not analyzed, since calls inside them are not
+         * affected by --wrap at all.
+         * @return true if the file is analyzed
+         * @throw std::runtime_error if the file cannot be read
+         */
+        bool AddFile(const std::string &file_name);
+
+        /**
+         * Analyzes a relocatable object file
+         */
+        void AddObject(const ElfFile &elf);
+
+        const InfoMap &Symbols() const { return infos; }
+
+        /**
+         * @return wrapped symbols which no analyzed object references through
+         * --wrap, so their fakes are not called from the analyzed objects
+         */
+        std::set<std::string> Unreferenced() const;
+
+        /**
+         * Prints a summary line for each wrapped symbol, with hints about
+         * calls which cannot be faked
+         */
+        void Report(std::ostream &out) const;
+
+    private:
+        InfoMap infos;
+};
+
+#endif /* CALLSITEANALYSIS_H_ */
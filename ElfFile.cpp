@@ -0,0 +1,341 @@
+/*
+ * ElfFile.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "ElfFile.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <elf.h>
+
+using namespace std;
+
+namespace
+{
+
+struct Elf32Traits
+{
+    typedef Elf32_Ehdr Ehdr;
+    typedef Elf32_Shdr Shdr;
+    typedef Elf32_Sym Sym;
+    typedef Elf32_Rel Rel;
+    typedef Elf32_Rela Rela;
+    static unsigned char Bind(unsigned char info) { return ELF32_ST_BIND(info); }
+    static unsigned char Type(unsigned char info) { return ELF32_ST_TYPE(info); }
+    static uint64_t RelSym(uint64_t info) { return ELF32_R_SYM(info); }
+};
+
+struct Elf64Traits
+{
+    typedef Elf64_Ehdr Ehdr;
+    typedef Elf64_Shdr Shdr;
+    typedef Elf64_Sym Sym;
+    typedef Elf64_Rel Rel;
+    typedef Elf64_Rela Rela;
+    static unsigned char Bind(unsigned char info) { return ELF64_ST_BIND(info); }
+    static unsigned char Type(unsigned char info) { return ELF64_ST_TYPE(info); }
+    static uint64_t RelSym(uint64_t info) { return ELF64_R_SYM(info); }
+};
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+const unsigned char host_elf_data = ELFDATA2LSB;
+#else
+const unsigned char host_elf_data = ELFDATA2MSB;
+#endif
+
+// ELF structures are not necessarily aligned inside our buffer (e.g. inside
+// an archive), so they are always copied
+template <typename T>
+T Get(const string &data, uint64_t offset)
+{
+    if (offset > data.size() || data.size() - offset < sizeof(T))
+        throw runtime_error("Truncated or corrupted ELF file");
+    T t;
+    memcpy(&t, data.data() + offset, sizeof(T));
+    return t;
+}
+
+template <typename T>
+void Put(string &data, uint64_t offset, const T &t)
+{
+    memcpy(&data[offset], &t, sizeof(T));
+}
+
+template <typename Traits>
+vector<typename Traits::Shdr> SectionHeaders(const string &data)
+{
+    auto ehdr = Get<typename Traits::Ehdr>(data, 0);
+    vector<typename Traits::Shdr> sections;
+    if (ehdr.e_shoff == 0)
+        return sections;
+
+    uint64_t shnum = ehdr.e_shnum;
+    // extended section numbering: actual count is stored in section 0
+    if (shnum == 0)
+        shnum = Get<typename Traits::Shdr>(data, ehdr.e_shoff).sh_size;
+    sections.reserve(shnum);
+    for (uint64_t i = 0; i < shnum; ++i)
+        sections.push_back(Get<typename Traits::Shdr>(data,
+            ehdr.e_shoff + i * ehdr.e_shentsize));
+    return sections;
+}
+
+template <typename Shdr>
+string_view SectionData(const string &data, const Shdr &shdr)
+{
+    if (shdr.sh_type == SHT_NOBITS)
+        return string_view();
+    if (shdr.sh_offset > data.size()
+            || data.size() - shdr.sh_offset < shdr.sh_size)
+        throw runtime_error("Truncated or corrupted ELF file");
+    return string_view(data.data() + shdr.sh_offset, shdr.sh_size);
+}
+
+string_view StringAt(string_view strtab, uint64_t offset)
+{
+    if (offset >= strtab.size())
+        throw runtime_error("Invalid ELF string table offset");
+    auto end = strtab.find('\0', offset);
+    if (end == string_view::npos)
+        end = strtab.size();
+    return strtab.substr(offset, end - offset);
+}
+
+/// @return the section names string table, or an empty one if there is none
+template <typename Traits>
+string_view SectionNames(const string &data,
+    const vector<typename Traits::Shdr> &sections)
+{
+    uint64_t shstrndx = Get<typename Traits::Ehdr>(data, 0).e_shstrndx;
+    // extended section numbering: actual index is stored in section 0
+    if (shstrndx == SHN_XINDEX && !sections.empty())
+        shstrndx = sections[0].sh_link;
+    if (shstrndx >= sections.size())
+        return string_view();
+    return SectionData(data, sections[shstrndx]);
+}
+
+}  // namespace
+
+
+ElfFile::ElfFile(std::string data): data(std::move(data))
+{
+    if (!IsSupported(this->data))
+        throw runtime_error("Not a supported ELF file");
+    is64 = this->data[EI_CLASS] == ELFCLASS64;
+}
+
+bool ElfFile::IsSupported(std::string_view data)
+{
+    return data.size() >= EI_NIDENT && memcmp(data.data(), ELFMAG, SELFMAG) == 0
+            && (data[EI_CLASS] == ELFCLASS32 || data[EI_CLASS] == ELFCLASS64)
+            && data[EI_DATA] == host_elf_data;
+}
+
+bool ElfFile::IsSharedObject(std::string_view data)
+{
+    if (!IsSupported(data) || data.size() < EI_NIDENT + sizeof(Elf64_Half))
+        return false;
+    // e_type has the same offset & size in 32 & 64 bit headers
+    Elf64_Half type;
+    memcpy(&type, data.data() + EI_NIDENT, sizeof(type));
+    return type == ET_DYN;
+}
+
+std::vector<ElfFile::Symbol> ElfFile::Symbols() const
+{
+    if (is64)
+        return SymbolsImpl<Elf64Traits>();
+    return SymbolsImpl<Elf32Traits>();
+}
+
+std::vector<std::string_view> ElfFile::Sections(std::string_view name) const
+{
+    if (is64)
+        return SectionsImpl<Elf64Traits>(name);
+    return SectionsImpl<Elf32Traits>(name);
+}
+
+std::vector<ElfFile::Reference> ElfFile::References() const
+{
+    if (is64)
+        return ReferencesImpl<Elf64Traits>();
+    return ReferencesImpl<Elf32Traits>();
+}
+
+size_t ElfFile::RenameSymbols(const RenameMap &renames)
+{
+    if (is64)
+        return RenameSymbolsImpl<Elf64Traits>(renames);
+    return RenameSymbolsImpl<Elf32Traits>(renames);
+}
+
+template <typename Traits>
+std::vector<ElfFile::Symbol> ElfFile::SymbolsImpl() const
+{
+    typedef typename Traits::Sym Sym;
+    auto sections = SectionHeaders<Traits>(data);
+
+    const bool shared = Get<typename Traits::Ehdr>(data, 0).e_type == ET_DYN;
+    const uint32_t preferred = shared ? SHT_DYNSYM : SHT_SYMTAB;
+    const typename Traits::Shdr *symtab = nullptr;
+    for (const auto &s: sections)
+        if (s.sh_type == preferred || (!symtab
+                && (s.sh_type == SHT_SYMTAB || s.sh_type == SHT_DYNSYM)))
+            symtab = &s;
+
+    vector<Symbol> symbols;
+    if (!symtab || symtab->sh_link >= sections.size())
+        return symbols;
+
+    auto strtab = SectionData(data, sections[symtab->sh_link]);
+    auto syms = SectionData(data, *symtab);
+    // the first symbol is always the null symbol
+    for (size_t off = sizeof(Sym); off + sizeof(Sym) <= syms.size();
+            off += sizeof(Sym))
+    {
+        auto sym = Get<Sym>(data, symtab->sh_offset + off);
+        if (sym.st_name == 0)
+            continue;
+        symbols.push_back(Symbol { StringAt(strtab, sym.st_name),
+            Traits::Bind(sym.st_info), Traits::Type(sym.st_info),
+            sym.st_shndx, sym.st_value, sym.st_size });
+    }
+    return symbols;
+}
+
+template <typename Traits>
+std::vector<std::string_view> ElfFile::SectionsImpl(std::string_view name) const
+{
+    auto sections = SectionHeaders<Traits>(data);
+    auto shstrtab = SectionNames<Traits>(data, sections);
+
+    vector<string_view> result;
+    if (shstrtab.empty())
+        return result;
+    for (const auto &s: sections)
+        if (s.sh_name && StringAt(shstrtab, s.sh_name) == name)
+            result.push_back(SectionData(data, s));
+    return result;
+}
+
+template <typename Traits>
+std::vector<ElfFile::Reference> ElfFile::ReferencesImpl() const
+{
+    auto sections = SectionHeaders<Traits>(data);
+    auto shstrtab = SectionNames<Traits>(data, sections);
+
+    vector<Reference> refs;
+
+    for (const auto &s: sections)
+    {
+        if ((s.sh_type != SHT_REL && s.sh_type != SHT_RELA)
+                || s.sh_info >= sections.size()
+                || s.sh_link >= sections.size())
+            continue;
+        const auto &target = sections[s.sh_info];
+        if (!(target.sh_flags & SHF_ALLOC) || (target.sh_name
+                && !shstrtab.empty()
+                && StringAt(shstrtab, target.sh_name) == ".eh_frame"))
+            continue;
+        const auto &symtab = sections[s.sh_link];
+        if (symtab.sh_link >= sections.size())
+            continue;
+        auto strtab = SectionData(data, sections[symtab.sh_link]);
+        if (s.sh_type == SHT_RELA)
+            AddReferences<Traits, typename Traits::Rela>(s, target, strtab,
+                symtab, refs);
+        else
+            AddReferences<Traits, typename Traits::Rel>(s, target, strtab,
+                symtab, refs);
+    }
+    return refs;
+}
+
+template <typename Traits, typename Rel>
+void ElfFile::AddReferences(const typename Traits::Shdr &relocs,
+    const typename Traits::Shdr &target, std::string_view strtab,
+    const typename Traits::Shdr &symtab, std::vector<Reference> &refs) const
+{
+    typedef typename Traits::Sym Sym;
+    const bool from_code = target.sh_flags & SHF_EXECINSTR;
+    for (uint64_t off = 0; off + sizeof(Rel) <= relocs.sh_size;
+            off += sizeof(Rel))
+    {
+        auto rel = Get<Rel>(data, relocs.sh_offset + off);
+        auto sym_index = Traits::RelSym(rel.r_info);
+        if (sym_index == 0 || (sym_index + 1) * sizeof(Sym) > symtab.sh_size)
+            continue;
+        auto sym = Get<Sym>(data, symtab.sh_offset + sym_index * sizeof(Sym));
+        if (sym.st_name == 0 || Traits::Type(sym.st_info) == STT_SECTION)
+            continue;
+        refs.push_back(Reference { StringAt(strtab, sym.st_name),
+            sym.st_shndx != SHN_UNDEF, from_code });
+    }
+}
+
+template <typename Traits>
+size_t ElfFile::RenameSymbolsImpl(const RenameMap &renames)
+{
+    typedef typename Traits::Sym Sym;
+    auto ehdr = Get<typename Traits::Ehdr>(data, 0);
+    auto sections = SectionHeaders<Traits>(data);
+
+    size_t renamed = 0;
+    for (const auto &symtab: sections)
+    {
+        // dynamic symbols are also referenced by hash tables, so they cannot
+        // be renamed this way
+        if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= sections.size())
+            continue;
+
+        // read string table again, it might be moved by a previous symtab
+        auto strtab_hdr = Get<typename Traits::Shdr>(data,
+            ehdr.e_shoff + symtab.sh_link * ehdr.e_shentsize);
+        string strtab(SectionData(data, strtab_hdr));
+        map<string, uint32_t> added_names;
+        string added;
+
+        for (uint64_t off = sizeof(Sym); off + sizeof(Sym) <= symtab.sh_size;
+                off += sizeof(Sym))
+        {
+            auto sym = Get<Sym>(data, symtab.sh_offset + off);
+            if (sym.st_name == 0)
+                continue;
+            auto r = renames.find(StringAt(strtab, sym.st_name));
+            if (r == renames.end())
+                continue;
+
+            auto name = added_names.find(r->second);
+            if (name == added_names.end())
+            {
+                uint32_t name_off = strtab.size() + added.size();
+                added += r->second;
+                added += '\0';
+                name = added_names.insert(make_pair(r->second, name_off)).first;
+            }
+            sym.st_name = name->second;
+            Put(data, symtab.sh_offset + off, sym);
+            ++renamed;
+        }
+
+        if (!added.empty())
+        {
+            strtab_hdr.sh_offset = data.size();
+            strtab_hdr.sh_size = strtab.size() + added.size();
+            data += strtab;
+            data += added;
+            Put(data, ehdr.e_shoff + symtab.sh_link * ehdr.e_shentsize,
+                strtab_hdr);
+        }
+    }
+    return renamed;
+}
@@ -0,0 +1,123 @@
+/*
+ * ElfFile.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef ELFFILE_H_
+#define ELFFILE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * An in-memory ELF object file (32 or 64 bit, in host byte order), providing
+ * access to its symbols and the ability to rename them without running
+ * external tools.
+ */
+class ElfFile
+{
+    public:
+        typedef std::map<std::string, std::string, std::less<>> RenameMap;
+
+        struct Symbol
+        {
+            std::string_view name;
+            unsigned char bind;
+            unsigned char type;
+            uint16_t shndx;
+            uint64_t value;
+            uint64_t size;
+        };
+
+        /// a symbol referenced by a relocation
+        struct Reference
+        {
+            std::string_view symbol;
+            /// the symbol is defined in this file, so the reference is
+            /// resolved by the assembler/linker without using --wrap
+            bool defined;
+            /// the reference is made from executable code, e.g. a call
+            bool from_code;
+        };
+
+    public:
+        /**
+         * @param data contents of an ELF file
+         * @throw std::runtime_error if @p data is not a supported ELF file
+         */
+        explicit ElfFile(std::string data);
+
+        /**
+         * @return true if @p data is an ELF file which can be processed by
+         * this class
+         */
+        static bool IsSupported(std::string_view data);
+
+        /**
+         * @return true if @p data is a supported ELF shared object
+         */
+        static bool IsSharedObject(std::string_view data);
+
+        const std::string &Data() const { return data; }
+        std::string &&Release() { return std::move(data); }
+
+        /**
+         * @return all symbols in the static symbol table (.symtab), or the
+         * dynamic symbol table if there is no static one or this is a shared
+         * object, since only exported symbols can be wrapped. The names point into
+         * the internal data, and are invalidated by RenameSymbols().
+         */
+        std::vector<Symbol> Symbols() const;
+
+        /**
+         * @return contents of all sections named @p name. They point into the
+         * internal data, and are invalidated by RenameSymbols().
+         */
+        std::vector<std::string_view> Sections(std::string_view name) const;
+
+        /**
+         * @return symbols referenced by relocations of allocated sections,
+         * i.e. calls and address references from code and data; one item per
+         * relocation. Relocations against sections and unwind information
+         * (.eh_frame) are not included.
+         */
+        std::vector<Reference> References() const;
+
+        /**
+         * Renames symbols in all symbol tables according to @p renames. Each
+         * modified string table is rebuilt with the new names and moved to the
+         * end of the file.
+         * @return number of renamed symbols
+         */
+        size_t RenameSymbols(const RenameMap &renames);
+
+    private:
+        std::string data;
+        bool is64;
+
+        template <typename Traits>
+        std::vector<Symbol> SymbolsImpl() const;
+        template <typename Traits>
+        std::vector<std::string_view> SectionsImpl(std::string_view name) const;
+        template <typename Traits>
+        std::vector<Reference> ReferencesImpl() const;
+        template <typename Traits, typename Rel>
+        void AddReferences(const typename Traits::Shdr &relocs,
+            const typename Traits::Shdr &target, std::string_view strtab,
+            const typename Traits::Shdr &symtab,
+            std::vector<Reference> &refs) const;
+        template <typename Traits>
+        size_t RenameSymbolsImpl(const RenameMap &renames);
+};
+
+#endif /* ELFFILE_H_ */
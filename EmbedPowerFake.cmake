@@ -7,17 +7,34 @@ set(POWERFAKE_DIR ${CMAKE_CURRENT_LIST_DIR})
 include(${POWERFAKE_DIR}/cmake/PowerFakeFunctions.cmake)
 
 add_library(powerfake STATIC ${POWERFAKE_DIR}/powerfake.cpp
-    ${POWERFAKE_DIR}/powerfake.h)
+    ${POWERFAKE_DIR}/powerfake.h
+    ${POWERFAKE_DIR}/powerfake_record.h ${POWERFAKE_DIR}/powerfake_memo.h)
 target_link_libraries(powerfake PUBLIC Boost::boost)
 add_library(PowerFake::powerfake ALIAS powerfake)
 
 set(pair_sources ${POWERFAKE_DIR}/powerfake ${POWERFAKE_DIR}/SymbolAliasMap
-    ${POWERFAKE_DIR}/NMSymbolReader ${POWERFAKE_DIR}/Reader)
+    ${POWERFAKE_DIR}/NMSymbolReader ${POWERFAKE_DIR}/Reader
+    ${POWERFAKE_DIR}/MangledNameFilter ${POWERFAKE_DIR}/ElfFile
+    ${POWERFAKE_DIR}/ArchiveFile ${POWERFAKE_DIR}/SymbolRenamer
+    ${POWERFAKE_DIR}/FileUtils ${POWERFAKE_DIR}/BindCache
+    ${POWERFAKE_DIR}/SymbolIndex ${POWERFAKE_DIR}/SymbolPipeline
+    ${POWERFAKE_DIR}/BindStats ${POWERFAKE_DIR}/PrototypeManifest
+    ${POWERFAKE_DIR}/PrototypeNotes ${POWERFAKE_DIR}/CallSiteAnalysis
+    ${POWERFAKE_DIR}/WrapperShards)
 set(bindfakes_core_sources $<JOIN:${pair_sources},.cpp >.cpp)
 set(bindfakes_core_headers $<JOIN:${pair_sources},.h >.h)
 
 add_library(pw_bindfakes STATIC ${POWERFAKE_DIR}/bind_fakes.cpp
     ${bindfakes_core_sources} ${bindfakes_core_headers})
 set_property(TARGET pw_bindfakes APPEND PROPERTY COMPILE_DEFINITIONS BIND_FAKES)
-target_link_libraries(pw_bindfakes PUBLIC Boost::boost)
+find_package(Threads REQUIRED)
+target_link_libraries(pw_bindfakes PUBLIC Boost::boost Threads::Threads)
 add_library(PowerFake::pw_bindfakes ALIAS pw_bindfakes)
+
+# Generic bind_fakes binary, which reads wrapped function prototypes from
+# wrapper objects or manifest files rather than being linked with wrapper
+# libraries
+file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/bind_fakes_main.cpp "")
+add_executable(bind_fakes ${CMAKE_CURRENT_BINARY_DIR}/bind_fakes_main.cpp)
+target_link_libraries(bind_fakes pw_bindfakes)
+add_executable(PowerFake::bind_fakes ALIAS bind_fakes)
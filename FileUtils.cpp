@@ -0,0 +1,109 @@
+/*
+ * FileUtils.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "FileUtils.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+
+std::string ReadFile(const std::string &file_name)
+{
+    ifstream in(file_name, ios::binary);
+    if (!in)
+        throw runtime_error("Cannot open file: " + file_name);
+    ostringstream contents;
+    contents << in.rdbuf();
+    if (in.bad())
+        throw runtime_error("Error reading file: " + file_name);
+    return contents.str();
+}
+
+std::string ReadFileHead(const std::string &file_name, size_t max_size)
+{
+    ifstream in(file_name, ios::binary);
+    string head(max_size, '\0');
+    in.read(&head[0], max_size);
+    head.resize(in.gcount());
+    return head;
+}
+
+void WriteFileAtomically(const std::string &file_name,
+    std::string_view contents)
+{
+    const string tmp_name = file_name + ".pftmp" + to_string(getpid());
+    {
+        ofstream out(tmp_name, ios::binary | ios::trunc);
+        out.write(contents.data(), contents.size());
+        out.close();
+        if (!out)
+        {
+            remove(tmp_name.c_str());
+            throw runtime_error("Error writing file: " + tmp_name);
+        }
+    }
+    if (rename(tmp_name.c_str(), file_name.c_str()) != 0)
+    {
+        remove(tmp_name.c_str());
+        throw runtime_error("Cannot replace file: " + file_name);
+    }
+}
+
+bool WriteFileIfChanged(const std::string &file_name,
+    std::string_view contents)
+{
+    ifstream in(file_name, ios::binary);
+    if (in)
+    {
+        ostringstream old;
+        old << in.rdbuf();
+        if (!in.bad() && old.str() == contents)
+            return false;
+    }
+    WriteFileAtomically(file_name, contents);
+    return true;
+}
+
+void CreateDirectories(const std::string &dir)
+{
+    // a leading '/' doesn't need a directory
+    for (size_t pos = 0; pos != string::npos; )
+    {
+        pos = dir.find('/', pos + 1);
+        const string path = dir.substr(0, pos);
+        if (mkdir(path.c_str(), 0777) != 0 && errno != EEXIST)
+            throw runtime_error("Cannot create directory: " + path);
+    }
+}
+
+uint64_t ContentHash(std::string_view data, uint64_t seed)
+{
+    uint64_t hash = seed;
+    for (unsigned char c: data)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t FileHash(const std::string &file_name)
+{
+    return ContentHash(ReadFile(file_name));
+}
@@ -0,0 +1,68 @@
+/*
+ * FileUtils.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef FILEUTILS_H_
+#define FILEUTILS_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @return the whole contents of @p file_name
+ * @throw std::runtime_error if the file cannot be read
+ */
+std::string ReadFile(const std::string &file_name);
+
+/**
+ * @return at most @p max_size bytes from the start of @p file_name, or an
+ * empty string if the file cannot be read
+ */
+std::string ReadFileHead(const std::string &file_name, size_t max_size);
+
+/**
+ * Writes @p contents into a temporary file beside @p file_name and renames it
+ * to @p file_name, so that readers never see a partially written file.
+ * @throw std::runtime_error on failure
+ */
+void WriteFileAtomically(const std::string &file_name,
+    std::string_view contents);
+
+/**
+ * Writes @p contents into @p file_name atomically, unless it already has the
+ * same contents; so that its timestamp is kept for build tools.
+ * @return true if the file is written
+ * @throw std::runtime_error on failure
+ */
+bool WriteFileIfChanged(const std::string &file_name,
+    std::string_view contents);
+
+/**
+ * Creates directory @p dir and its missing parents
+ * @throw std::runtime_error on failure
+ */
+void CreateDirectories(const std::string &dir);
+
+/**
+ * @return a 64 bit content hash (FNV-1a) of @p data, continuing from @p seed
+ * to allow hashing multiple pieces of data
+ */
+uint64_t ContentHash(std::string_view data,
+    uint64_t seed = 0xcbf29ce484222325ULL);
+
+/**
+ * @return content hash of the file @p file_name
+ * @throw std::runtime_error if the file cannot be read
+ */
+uint64_t FileHash(const std::string &file_name);
+
+#endif /* FILEUTILS_H_ */
@@ -0,0 +1,118 @@
+/*
+ * MangledNameFilter.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "MangledNameFilter.h"
+
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+using PowerFake::internal::FunctionPrototype;
+using PowerFake::internal::WrapperBase;
+
+
+MangledNameFilter::MangledNameFilter(const WrapperBase::Prototypes &protos)
+{
+    for (const auto &p: protos)
+        AddPrototype(p.second);
+}
+
+void MangledNameFilter::AddPrototype(const FunctionPrototype &proto)
+{
+    string ident = BaseIdentifier(proto.name);
+    // operators are mangled using special abbreviations (e.g. 'pl' for
+    // operator+) rather than a <source-name>, so we cannot filter them
+    if (ident.empty() || ident == "operator")
+        accept_all_mangled = true;
+    else
+    {
+        identifiers.insert(hash<string_view>()(ident));
+        max_ident_len = max(max_ident_len, ident.size());
+    }
+}
+
+bool MangledNameFilter::MayMatch(const char *symbol_name) const
+{
+    const string_view symbol(symbol_name);
+
+    // C functions & other non C++ symbols are not mangled; GCC clones of C
+    // functions have a suffix, e.g. folan.isra.0
+    if (symbol.size() < 2 || symbol[0] != '_' || symbol[1] != 'Z')
+        return identifiers.count(hash<string_view>()(symbol.substr(0,
+            symbol.find('.'))));
+
+    if (accept_all_mangled)
+        return true;
+
+    // Look for all possible <source-name>s. As the identifier itself might end
+    // with digits, each suffix of a digit sequence is tried as the length.
+    for (string_view::size_type i = 2; i < symbol.size(); ++i)
+    {
+        if (!isdigit(static_cast<unsigned char>(symbol[i])))
+            continue;
+        auto run_end = i;
+        while (run_end < symbol.size()
+                && isdigit(static_cast<unsigned char>(symbol[run_end])))
+            ++run_end;
+
+        string_view::size_type len = 0, scale = 1;
+        for (auto d = run_end; d > i && scale <= max_ident_len; --d)
+        {
+            len += (symbol[d-1] - '0') * scale;
+            scale *= 10;
+            if (len == 0 || len > max_ident_len
+                    || run_end + len > symbol.size())
+                continue;
+            if (identifiers.count(
+                hash<string_view>()(symbol.substr(run_end, len))))
+                return true;
+        }
+        i = run_end;
+    }
+    return false;
+}
+
+string MangledNameFilter::BaseIdentifier(const string &name)
+{
+    // operator functions, e.g. A::operator<, B::operator int
+    for (auto op = name.find("operator"); op != string::npos;
+            op = name.find("operator", op + 1))
+    {
+        bool starts_name = (op == 0 || name[op-1] == ':' || name[op-1] == ' ');
+        char next = op + 8 < name.size() ? name[op + 8] : '\0';
+        if (starts_name && !isalnum(static_cast<unsigned char>(next))
+                && next != '_')
+            return "operator";
+    }
+
+    auto end = name.size();
+    // strip template arguments
+    if (end > 0 && name[end-1] == '>')
+    {
+        int depth = 0;
+        for (; end > 0; --end)
+        {
+            if (name[end-1] == '>')
+                ++depth;
+            else if (name[end-1] == '<' && --depth == 0)
+            {
+                --end;
+                break;
+            }
+        }
+    }
+    auto begin = name.rfind(':', end == 0 ? 0 : end - 1);
+    begin = (begin == string::npos) ? 0 : begin + 1;
+    if (begin >= end)
+        return "";
+    return name.substr(begin, end - begin);
+}
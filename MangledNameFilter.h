@@ -0,0 +1,62 @@
+/*
+ * MangledNameFilter.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef MANGLEDNAMEFILTER_H_
+#define MANGLEDNAMEFILTER_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "powerfake.h"
+
+/**
+ * Rejects symbols which can never match a wrapped function by looking only at
+ * their mangled form, so that demangling is only done for possible candidates.
+ *
+ * In Itanium C++ ABI, every name component of a function is mangled as a
+ * <source-name> (<length><identifier>), so the unqualified name of each
+ * wrapped function must appear as such a component in the mangled symbol.
+ * The filter is conservative: it might let some non-matching symbols pass, but
+ * never rejects a symbol which might match a wrapped function.
+ */
+class MangledNameFilter
+{
+    public:
+        MangledNameFilter() = default;
+        MangledNameFilter(
+            const PowerFake::internal::WrapperBase::Prototypes &protos);
+
+        /**
+         * Register the prototype of a wrapped function
+         */
+        void AddPrototype(const PowerFake::internal::FunctionPrototype &proto);
+
+        /**
+         * @return false if @p symbol_name cannot belong to any of the
+         * registered prototypes
+         */
+        bool MayMatch(const char *symbol_name) const;
+
+        /**
+         * @return the unqualified identifier of the function name @p name,
+         * without template arguments; e.g. folan for A::folan<char>.
+         */
+        static std::string BaseIdentifier(const std::string &name);
+
+    private:
+        /// hashes of identifiers, collisions only cause false positives
+        std::unordered_set<std::size_t> identifiers;
+        std::string::size_type max_ident_len = 0;
+        bool accept_all_mangled = false;
+};
+
+#endif /* MANGLEDNAMEFILTER_H_ */
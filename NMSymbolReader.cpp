@@ -12,7 +12,6 @@
 
 #include "NMSymbolReader.h"
 
-#include <cstring>
 #include <iostream>
 
 using namespace std;
@@ -27,21 +26,33 @@ NMSymbolReader::~NMSymbolReader()
 {
 }
 
-const char* NMSymbolReader::NextSymbol()
+std::string_view NMSymbolReader::NextSymbol()
 {
-    const char *nm_line = reader->ReadLine();
-    if (!nm_line)
-        return nullptr;
-
-    const char *symbol_name = strrchr(nm_line, ' ');
-    if (!symbol_name)
+    std::string_view nm_line;
+    // skip empty lines
+    while ((nm_line = reader->ReadLine()).data() && nm_line.empty())
+        ;
+    if (!nm_line.data())
+        return std::string_view();
+
+    auto name_start = nm_line.rfind(' ');
+    if (name_start == std::string_view::npos)
     {
         std::cerr << "Unknown input from nm: " << nm_line << std::endl;
-        return nullptr;
+        return std::string_view();
+    }
+    auto symbol_name = nm_line.substr(name_start + 1);
+    // strip symbol version of dynamic symbols, e.g. func@@VER_1. Lines are
+    // stored in the writable buffer of the reader, so the symbol is kept
+    // null-terminated
+    auto version = symbol_name.find('@');
+    if (version != std::string_view::npos)
+    {
+        const_cast<char *>(symbol_name.data())[version] = '\0';
+        symbol_name = symbol_name.substr(0, version);
     }
-    ++symbol_name;
-    if (leading_underscore && symbol_name[0] == '_')
-        ++symbol_name;
+    if (leading_underscore && !symbol_name.empty() && symbol_name[0] == '_')
+        symbol_name.remove_prefix(1);
 
     return symbol_name;
 }
@@ -15,6 +15,7 @@
 
 #include <stdio.h>
 #include <string>
+#include <string_view>
 
 #include "Reader.h"
 
@@ -24,7 +25,11 @@ class NMSymbolReader
         NMSymbolReader(Reader *reader, bool leading_underscore = false);
         ~NMSymbolReader();
 
-        const char *NextSymbol();
+        /**
+         * @return the next symbol, or an empty string_view at the end of
+         * input. It is valid until the next call, and is NUL terminated.
+         */
+        std::string_view NextSymbol();
 
     private:
         Reader *reader;
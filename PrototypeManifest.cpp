@@ -0,0 +1,78 @@
+/*
+ * PrototypeManifest.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "PrototypeManifest.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "FileUtils.h"
+
+using namespace std;
+using PowerFake::internal::FunctionPrototype;
+using PowerFake::internal::WrapperBase;
+
+namespace
+{
+const char MANIFEST_MAGIC[] = "powerfake-manifest 1";
+}
+
+
+/**
+ * Each prototype is stored in a line as:
+ *      proto <alias> <qual> <return type>\t<name>\t<params>
+ * since types and names might contain spaces, but never tabs.
+ */
+void PrototypeManifest::Write(const std::string &file_name,
+    const WrapperBase::Prototypes &protos)
+{
+    ostringstream out;
+    out << MANIFEST_MAGIC << '\n';
+    for (const auto &p: protos)
+    {
+        const auto &proto = p.second;
+        out << "proto " << proto.alias << ' ' << proto.qual << ' '
+                << proto.return_type << '\t' << proto.name << '\t'
+                << proto.params << '\n';
+    }
+    WriteFileAtomically(file_name, out.str());
+}
+
+std::vector<FunctionPrototype> PrototypeManifest::Read(
+    const std::string &file_name)
+{
+    ifstream in(file_name);
+    string line;
+    if (!getline(in, line))
+        throw runtime_error("Cannot read prototype manifest: " + file_name);
+    if (line != MANIFEST_MAGIC)
+        throw runtime_error("Invalid prototype manifest: " + file_name);
+
+    vector<FunctionPrototype> protos;
+    while (getline(in, line))
+    {
+        istringstream fields(line);
+        string type, alias, return_type, name, params;
+        uint32_t qual;
+        fields >> type >> alias >> qual;
+        fields.ignore(1);
+        getline(fields, return_type, '\t');
+        getline(fields, name, '\t');
+        getline(fields, params);
+        if (type != "proto" || fields.fail() || alias.empty() || name.empty())
+            throw runtime_error("Invalid prototype manifest entry in "
+                    + file_name + ": " + line);
+        protos.emplace_back(return_type, name, params, qual, alias);
+    }
+    return protos;
+}
@@ -0,0 +1,43 @@
+/*
+ * PrototypeManifest.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef PROTOTYPEMANIFEST_H_
+#define PROTOTYPEMANIFEST_H_
+
+#include <string>
+#include <vector>
+
+#include "powerfake.h"
+
+/**
+ * A text file containing prototypes of wrapped functions of a wrapper
+ * library, so that a generic bind_fakes binary can bind fakes without being
+ * linked with the wrapper library.
+ */
+class PrototypeManifest
+{
+    public:
+        /**
+         * Writes @p protos into @p file_name atomically
+         */
+        static void Write(const std::string &file_name,
+            const PowerFake::internal::WrapperBase::Prototypes &protos);
+
+        /**
+         * @return prototypes stored in @p file_name
+         * @throw std::runtime_error if the file cannot be read or is invalid
+         */
+        static std::vector<PowerFake::internal::FunctionPrototype> Read(
+            const std::string &file_name);
+};
+
+#endif /* PROTOTYPEMANIFEST_H_ */
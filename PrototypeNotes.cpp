@@ -0,0 +1,238 @@
+/*
+ * PrototypeNotes.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "PrototypeNotes.h"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <elf.h>
+#include <boost/core/demangle.hpp>
+
+#include "ArchiveFile.h"
+#include "FileUtils.h"
+
+using namespace std;
+using PowerFake::internal::FunctionPrototype;
+
+namespace
+{
+
+const string_view MARKER_PREFIX = "_ZN9PowerFake8internal16prototype_marker";
+const string_view MARKER_DEMANGLED = "PowerFake::internal::prototype_marker<";
+const string_view TAG_SUFFIX = "PowerFakeNoteTag";
+
+struct NoteData
+{
+    string name;
+    uint32_t qual;
+};
+
+uint32_t ReadWord(string_view data, size_t offset)
+{
+    uint32_t v;
+    memcpy(&v, data.data() + offset, sizeof(v));
+    return v;
+}
+
+/**
+ * Adds PowerFake notes in @p section to @p notes, keyed by alias
+ */
+void ParseNotes(string_view section, map<string, NoteData> &notes)
+{
+    const size_t name_len = sizeof(POWERFAKE_NOTE_NAME);
+    size_t pos = 0;
+    while (section.size() - pos >= 12)
+    {
+        const uint32_t namesz = ReadWord(section, pos);
+        const uint32_t descsz = ReadWord(section, pos + 4);
+        const uint32_t type = ReadWord(section, pos + 8);
+        const size_t name_pos = pos + 12;
+        const size_t desc_pos = name_pos + (namesz + 3ul) / 4 * 4;
+        const size_t next = desc_pos + (descsz + 3ul) / 4 * 4;
+        if (next > section.size() || next <= pos)
+            throw runtime_error("Corrupted PowerFake note section");
+        pos = next;
+
+        if (type != POWERFAKE_NOTE_TYPE || namesz != name_len
+                || section.substr(name_pos, name_len)
+                    != string_view(POWERFAKE_NOTE_NAME, name_len)
+                || descsz < 4)
+            continue;
+
+        // desc: qualifiers, then alias & function name separated by '\0'
+        auto strings = section.substr(desc_pos + 4, descsz - 4);
+        auto alias = strings.substr(0, strings.find('\0'));
+        if (alias.size() >= strings.size())
+            throw runtime_error("Corrupted PowerFake note");
+        auto name = strings.substr(alias.size() + 1);
+        name = name.substr(0, name.find('\0'));
+        notes[string(alias)] = NoteData { string(name),
+            ReadWord(section, desc_pos) };
+    }
+}
+
+/**
+ * Splits top level template arguments of a demangled template name
+ */
+vector<string> TemplateArgs(string_view args)
+{
+    vector<string> result;
+    int depth = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        char c = args[i];
+        if (c == '<' || c == '(' || c == '[')
+            ++depth;
+        else if (c == '>' || c == ')' || c == ']')
+            --depth;
+        else if (c == ',' && depth == 0)
+        {
+            result.emplace_back(args.substr(start, i - start));
+            start = i + 1;
+            while (start < args.size() && args[start] == ' ')
+                ++start;
+        }
+    }
+    result.emplace_back(args.substr(start));
+    return result;
+}
+
+bool RemoveSuffix(string &s, string_view suffix)
+{
+    if (s.size() < suffix.size()
+            || s.compare(s.size() - suffix.size(), suffix.size(), suffix) != 0)
+        return false;
+    s.erase(s.size() - suffix.size());
+    return true;
+}
+
+}  // namespace
+
+
+std::vector<FunctionPrototype> PrototypeNotes::Read(
+    const std::string &file_name)
+{
+    string contents = ReadFile(file_name);
+    vector<FunctionPrototype> protos;
+    if (ArchiveFile::IsArchive(contents))
+    {
+        ArchiveFile ar(move(contents));
+        for (const auto &member: ar.Members())
+        {
+            if (member.special || !ElfFile::IsSupported(member.Contents()))
+                continue;
+            auto member_protos = Read(ElfFile(string(member.Contents())));
+            move(member_protos.begin(), member_protos.end(),
+                back_inserter(protos));
+        }
+    }
+    else if (ElfFile::IsSupported(contents))
+        protos = Read(ElfFile(move(contents)));
+    return protos;
+}
+
+std::vector<FunctionPrototype> PrototypeNotes::Read(const ElfFile &elf)
+{
+    map<string, NoteData> notes;
+    for (auto section: elf.Sections(POWERFAKE_NOTE_SECTION))
+        ParseNotes(section, notes);
+
+    vector<FunctionPrototype> protos;
+    if (notes.empty())
+        return protos;
+
+    for (const auto &sym: elf.Symbols())
+    {
+        if (sym.shndx == SHN_UNDEF
+                || sym.name.substr(0, MARKER_PREFIX.size()) != MARKER_PREFIX)
+            continue;
+
+        // PowerFake::internal::prototype_marker<Tag, FuncType, Class>
+        string demangled = boost::core::demangle(string(sym.name).c_str());
+        if (demangled.compare(0, MARKER_DEMANGLED.size(), MARKER_DEMANGLED)
+                != 0 || demangled.back() != '>')
+            continue;
+        auto args = TemplateArgs(string_view(demangled).substr(
+            MARKER_DEMANGLED.size(),
+            demangled.size() - MARKER_DEMANGLED.size() - 1));
+        if (args.size() != 3 || !RemoveSuffix(args[0], TAG_SUFFIX))
+            continue;
+
+        // the tag is declared where WRAP_FUNCTION() is used
+        auto scope = args[0].rfind("::");
+        string alias = scope == string::npos ? args[0]
+                : args[0].substr(scope + 2);
+        auto note = notes.find(alias);
+        if (note == notes.end())
+            continue;
+
+        string return_type, class_name, params;
+        if (!SplitFunctionType(args[1], return_type, class_name, params))
+            throw runtime_error("Unsupported wrapped function type: " + args[1]);
+        if (args[2] != "void") // static member function
+            class_name = args[2];
+
+        // similar to PrototypeExtractor::Extract(): scoping of member
+        // functions is retrieved from the class name
+        string name = note->second.name;
+        if (!class_name.empty())
+        {
+            auto f = name.rfind("::");
+            name = class_name + (f == string::npos ? "::" + name
+                    : name.substr(f));
+        }
+        protos.emplace_back(return_type, name, params, note->second.qual,
+            alias);
+    }
+    return protos;
+}
+
+bool PrototypeNotes::SplitFunctionType(const std::string &func_type,
+    std::string &return_type, std::string &class_name, std::string &params)
+{
+    // the declarator, e.g. (*) or (A::*), is the first parenthesis outside
+    // of template arguments
+    size_t open = string::npos;
+    int depth = 0;
+    for (size_t i = 0; i < func_type.size() && open == string::npos; ++i)
+    {
+        if (func_type[i] == '<')
+            ++depth;
+        else if (func_type[i] == '>')
+            --depth;
+        else if (func_type[i] == '(' && depth == 0)
+            open = i;
+    }
+    if (open == string::npos)
+        return false;
+    auto close = func_type.find(')', open);
+    if (close == string::npos || func_type[close - 1] != '*')
+        return false;
+
+    class_name = func_type.substr(open + 1, close - open - 2);
+    if (!class_name.empty() && !RemoveSuffix(class_name, "::"))
+        return false;
+
+    // same as PrototypeExtractor::Extract()
+    params = func_type.substr(func_type.rfind('('));
+
+    return_type = func_type.substr(0, open);
+    RemoveSuffix(return_type, " ");
+    if (!RemoveSuffix(return_type, "&&"))
+        RemoveSuffix(return_type, "&");
+    while (RemoveSuffix(return_type, " const")
+            || RemoveSuffix(return_type, " volatile"))
+        ;
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * PrototypeNotes.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef PROTOTYPENOTES_H_
+#define PROTOTYPENOTES_H_
+
+#include <string>
+#include <vector>
+
+#include "powerfake.h"
+#include "ElfFile.h"
+
+/**
+ * Reads prototypes of wrapped functions from wrapper objects statically,
+ * using PrototypeNote records and prototype_marker<> symbols emitted by
+ * WRAP_FUNCTION() macros. The results are the same as prototypes registered
+ * by running static initializers of wrapper objects.
+ */
+class PrototypeNotes
+{
+    public:
+        /**
+         * @return prototypes recorded in the given object file or static
+         * library; other files are ignored
+         * @throw std::runtime_error if the file cannot be read
+         */
+        static std::vector<PowerFake::internal::FunctionPrototype> Read(
+            const std::string &file_name);
+
+        /**
+         * @return prototypes recorded in the given object file
+         */
+        static std::vector<PowerFake::internal::FunctionPrototype> Read(
+            const ElfFile &elf);
+
+        /**
+         * Splits a demangled function pointer type, e.g.
+         * "char const* (A::*)(int)", into its return type without top level
+         * reference and cv-qualifiers (as given by typeid), class name (empty
+         * for non-member functions) and parameters.
+         * @return false if @p func_type is not a function pointer type
+         */
+        static bool SplitFunctionType(const std::string &func_type,
+            std::string &return_type, std::string &class_name,
+            std::string &params);
+};
+
+#endif /* PROTOTYPENOTES_H_ */
@@ -11,27 +11,62 @@
  */
 
 #include "Reader.h"
+#include <cstring>
 #include <stdexcept>
 
-Reader::Reader(FILE *input_file): in_file(input_file)
+Reader::Reader(FILE *input_file, size_t chunk_size) :
+        in_file(input_file), buffer(chunk_size + 1), chunk_size(chunk_size)
 {
-    line_buf.reserve(1000);
 }
 
-const char* Reader::ReadLine()
+std::string_view Reader::ReadLine()
 {
-    line_buf.clear();
-    int ch;
-    while ((ch = getc(in_file)) != EOF && ch != '\n')
-        line_buf += static_cast<char>(ch);
-    if (line_buf.empty())
-        return nullptr;
-    return line_buf.c_str();
+    while (true)
+    {
+        char *buf = buffer.data();
+        auto nl = static_cast<char *>(memchr(buf + scan, '\n', end - scan));
+        if (nl || (eof && begin < end))
+        {
+            // terminate the line in place, there is always room for it as
+            // the buffer is one byte larger than the data read into it
+            size_t line_end = nl ? nl - buf : end;
+            buf[line_end] = '\0';
+            std::string_view line(buf + begin, line_end - begin);
+            begin = scan = nl ? line_end + 1 : end;
+            return line;
+        }
+        if (eof)
+            return std::string_view();
+
+        // move the partial line to the start of the buffer, and grow the
+        // buffer if the line does not fit into it
+        if (begin > 0)
+        {
+            memmove(buf, buf + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if (buffer.size() - 1 - end < chunk_size / 2)
+            buffer.resize(buffer.size() + chunk_size);
+        scan = end;
+
+        size_t n = fread(buffer.data() + end, 1, buffer.size() - 1 - end,
+            in_file);
+        if (n == 0)
+        {
+            if (ferror(in_file))
+                throw std::runtime_error("Error reading input");
+            eof = true;
+        }
+        end += n;
+    }
 }
 
 FileReader::FileReader(std::string file_name) :
         Reader(fopen(file_name.c_str(), "r"))
 {
+    if (!in_file)
+        throw std::runtime_error("Cannot open file: " + file_name);
 }
 
 FileReader::~FileReader()
@@ -15,17 +15,39 @@
 
 #include <stdio.h>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class Reader
 {
     public:
-        Reader(FILE *input_file);
+        /**
+         * @param input_file the file to read lines from
+         * @param chunk_size the size of blocks read from @p input_file
+         */
+        Reader(FILE *input_file, size_t chunk_size = 1024 * 1024);
 
-        const char *ReadLine();
+        /**
+         * @return the next line without its new line character, or a null
+         * string_view (data() == nullptr) at the end of input. The line points
+         * into the internal buffer and is valid until the next call; it is
+         * followed by a NUL character, so data() can be used as a C string.
+         */
+        std::string_view ReadLine();
 
     protected:
         FILE *in_file;
-        std::string line_buf;
+
+    private:
+        std::vector<char> buffer;
+        size_t chunk_size;
+        /// start of unread data in buffer
+        size_t begin = 0;
+        /// end of valid data in buffer
+        size_t end = 0;
+        /// position to continue searching for a new line from
+        size_t scan = 0;
+        bool eof = false;
 };
 
 class FileReader: public Reader
@@ -12,6 +12,7 @@
 
 #include "SymbolAliasMap.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include "powerfake.h"
@@ -20,19 +21,39 @@ using namespace PowerFake;
 using namespace std;
 
 
+SymbolAliasMap::SymbolAliasMap() :
+        filter(WrapperBase::WrappedFunctions()), log(&cout)
+{
+}
+
 /**
  * For each symbol in the main library, finds its alias if it is wrapped and
  * inserts the alias and the actual symbol of the target function in sym_map.
+ * Symbols which cannot be a wrapped function are rejected before demangling.
  *
  * @param symbol_name the name of a symbol in main library, which might be faked
  */
 void SymbolAliasMap::AddSymbol(const char *symbol_name)
 {
+    if (!filter.MayMatch(symbol_name))
+        return;
+
     std::string demangled = boost::core::demangle(symbol_name);
 
     FindWrappedSymbol(WrapperBase::WrappedFunctions(), demangled, symbol_name);
 }
 
+/**
+ * Same as AddSymbol(symbol_name), but uses an already demangled name, e.g.
+ * from a SymbolIndex. Unlike AddSymbol(symbol_name), the symbol is not checked
+ * using IsCandidate().
+ */
+void SymbolAliasMap::AddSymbol(const char *symbol_name,
+    const std::string &demangled)
+{
+    FindWrappedSymbol(WrapperBase::WrappedFunctions(), demangled, symbol_name);
+}
+
 /**
  * @return if all wrapped symbols were found
  */
@@ -53,6 +74,65 @@ bool SymbolAliasMap::FoundAllWrappedSymbols() const
     return found_all;
 }
 
+/**
+ * Reports wrapped functions with clones which bypass --wrap. Such clones
+ * cannot be bound too: they have a different ABI (e.g. removed or scalarized
+ * parameters), or are only a part of the function body, so the wrapper of the
+ * original function cannot replace them.
+ */
+size_t SymbolAliasMap::ReportClones(std::ostream &out) const
+{
+    for (const auto &wfp: WrapperBase::WrappedFunctions())
+    {
+        const auto &wf = wfp.second;
+        auto c = clones.find(wf.alias);
+        if (c == clones.end())
+            continue;
+        out << "Warning: calls to " << wf.return_type << ' ' << wf.name
+                << wf.params << " might bypass its fake, as it has GCC "
+                "clone(s):";
+        for (const auto &clone: c->second)
+            out << ' ' << clone;
+        out << "\n\tCompile it with -fno-ipa-sra -fno-ipa-cp-clone "
+                "-fno-partial-inlining or mark it noipa to avoid clones"
+                << endl;
+    }
+    return clones.size();
+}
+
+void SymbolAliasMap::Merge(const SymbolAliasMap &other,
+    const std::string &source)
+{
+    for (const auto &sym: other.sym_map)
+    {
+        auto inserted = sym_map.insert(sym);
+        if (!inserted.second && inserted.first->second != sym.second)
+            *log << "Ignoring symbol " << sym.second << " of " << source
+                    << " for alias " << sym.first << ", already found: "
+                    << inserted.first->second << '\n';
+    }
+
+    // clones might be found in a library other than the one defining the
+    // function, e.g. if it is inlined there; only clones of an ignored
+    // symbol are skipped
+    for (const auto &other_clones: other.clones)
+    {
+        auto sym = sym_map.find(other_clones.first);
+        auto &alias_clones = clones[other_clones.first];
+        for (const auto &clone: other_clones.second)
+        {
+            if (sym != sym_map.end() && clone.compare(0,
+                    CloneSuffixPos(clone), sym->second) != 0)
+                continue;
+            if (find(alias_clones.begin(), alias_clones.end(), clone)
+                    == alias_clones.end())
+                alias_clones.push_back(clone);
+        }
+        if (alias_clones.empty())
+            clones.erase(other_clones.first);
+    }
+}
+
 /**
  * For a given symbol and its demangled name, finds corresponding prototype
  * from @a protos set and stores the mapping
@@ -60,26 +140,33 @@ bool SymbolAliasMap::FoundAllWrappedSymbols() const
  * @param demangled the demangled form of @a symbol_name
  * @param symbol_name a symbol in the object file
  */
-void SymbolAliasMap::FindWrappedSymbol(WrapperBase::Prototypes protos,
+void SymbolAliasMap::FindWrappedSymbol(const WrapperBase::Prototypes &protos,
     const std::string &demangled, const char *symbol_name)
 {
     if (!IsFunction(symbol_name, demangled))
         return;
 
+    auto clone_pos = CloneSuffixPos(symbol_name);
+    if (clone_pos != string::npos)
+    {
+        FindWrappedClone(protos, demangled, symbol_name, clone_pos);
+        return;
+    }
+
     string name = FunctionName(demangled);
 
     auto range = protos.equal_range(name);
     for (auto p = range.first; p != range.second; ++p)
     {
-        auto func = p->second;
+        const auto &func = p->second;
         if (IsSameFunction(demangled, func))
         {
             const string sig = func.name + func.params;
             auto inserted = sym_map.insert(make_pair(func.alias, symbol_name));
             if (inserted.second)
-                cout << "Found symbol for " << func.return_type << ' ' << sig
+                *log << "Found symbol for " << func.return_type << ' ' << sig
                         << " == " << symbol_name << " (" << demangled << ") "
-                        << endl;
+                        << '\n';
             else if (inserted.first->second != symbol_name)
             {
                 cerr << "Error: (BUG) duplicate symbols found for: "
@@ -92,6 +179,39 @@ void SymbolAliasMap::FindWrappedSymbol(WrapperBase::Prototypes protos,
     }
 }
 
+/**
+ * Records @p symbol_name if it is a clone of a wrapped function which can be
+ * called instead of it. Clones which are only the cold part of a function
+ * ([clone .cold]) are not entry points, so they are ignored.
+ */
+void SymbolAliasMap::FindWrappedClone(const WrapperBase::Prototypes &protos,
+    const std::string &demangled, const char *symbol_name,
+    std::string::size_type clone_pos)
+{
+    if (strcmp(symbol_name + clone_pos, ".cold") == 0)
+        return;
+
+    // demangled clones look like: folan(int) [clone .isra.0]
+    const string base = strncmp(symbol_name, "_Z", 2) == 0
+            ? demangled.substr(0, demangled.find(" [clone "))
+            : string(symbol_name, clone_pos);
+    auto range = protos.equal_range(FunctionName(base));
+    for (auto p = range.first; p != range.second; ++p)
+    {
+        const auto &func = p->second;
+        if (!IsSameFunction(base, func))
+            continue;
+        auto &alias_clones = clones[func.alias];
+        if (find(alias_clones.begin(), alias_clones.end(), symbol_name)
+                != alias_clones.end())
+            continue;
+        alias_clones.push_back(symbol_name);
+        *log << "Found clone of " << func.return_type << ' ' << func.name
+                << func.params << ": " << symbol_name << " (" << demangled
+                << ") " << '\n';
+    }
+}
+
 bool SymbolAliasMap::IsFunction(const char *symbol_name  [[maybe_unused]],
     const std::string &demangled)
 {
@@ -137,16 +257,33 @@ bool SymbolAliasMap::IsSameFunction(const std::string &demangled,
                     == (proto.params + qs).size() + 1;
     }
 
-    // TODO: Warn for similar symbols, e.g. <signature> [clone .cold]
-
     return false;
 }
 
+std::string::size_type SymbolAliasMap::CloneSuffixPos(
+    std::string_view symbol_name)
+{
+    static const char *clone_kinds[] = { "isra", "constprop", "part", "cold",
+        "clone" };
+    for (auto dot = symbol_name.find('.'); dot != string_view::npos;
+            dot = symbol_name.find('.', dot + 1))
+        for (const char *kind: clone_kinds)
+        {
+            const auto len = strlen(kind);
+            const auto end = dot + 1 + len;
+            if (symbol_name.substr(dot + 1, len) == kind
+                    && (end == symbol_name.size() || symbol_name[end] == '.'))
+                return dot;
+        }
+    return string::npos;
+}
+
 std::string SymbolAliasMap::FunctionName(const std::string &demangled)
 {
     auto name_end = demangled.find_first_of("[(");
+    // C function clones, e.g. folan.part.0
     if (name_end == string::npos)
-        return demangled;
+        return demangled.substr(0, CloneSuffixPos(demangled));
     auto name_begin = demangled.find_last_of(" >:", name_end);
     if (name_begin == string::npos)
         return demangled.substr(0, name_end);
@@ -14,8 +14,12 @@
 #define SYMBOLALIASMAP_H_
 
 #include "powerfake.h"
+#include "MangledNameFilter.h"
 #include <map>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 using PowerFake::internal::WrapperBase;
 
@@ -23,21 +27,74 @@ class SymbolAliasMap
 {
     public:
         typedef std::map<std::string, std::string> MapType;
+        typedef std::map<std::string, std::vector<std::string>> ClonesType;
 
     public:
+        SymbolAliasMap();
+
         void AddSymbol(const char *symbol_name);
+        void AddSymbol(const char *symbol_name, const std::string &demangled);
+        bool IsCandidate(const char *symbol_name) const
+        {
+            return filter.MayMatch(symbol_name);
+        }
         const MapType &Map() const { return sym_map; }
         bool FoundAllWrappedSymbols() const;
 
+        /**
+         * @return GCC clones (e.g. .isra.0, .constprop.0 and .part.0) of
+         * wrapped functions, which are called instead of the function itself
+         * by some callers, so these calls bypass --wrap. Maps aliases to
+         * clone symbols.
+         */
+        const ClonesType &Clones() const { return clones; }
+
+        /**
+         * Prints a warning for each wrapped function having clones
+         * @return number of wrapped functions having clones
+         */
+        size_t ReportClones(std::ostream &out) const;
+
+        /**
+         * Adds symbols found in @p other which are not found in this map yet,
+         * so that symbols found earlier take precedence. Clones of @p other
+         * are added even if their function is found in another library,
+         * except clones of the symbols which are ignored.
+         * @param source name of the library @p other is created from
+         */
+        void Merge(const SymbolAliasMap &other, const std::string &source);
+
+        /**
+         * Sets the stream receiving found symbol messages, e.g. to keep them
+         * in order when several maps are filled concurrently
+         */
+        void SetLog(std::ostream &out) { log = &out; }
+        std::ostream &Log() const { return *log; }
+
+        static bool IsFunction(const char *symbol_name,
+            const std::string &demangled);
+        static std::string FunctionName(const std::string &demangled);
+
+        /**
+         * @return position of GCC clone suffixes in @p symbol_name (e.g.
+         * .isra.0 or .cold), or npos if it is not a clone
+         */
+        static std::string::size_type CloneSuffixPos(
+            std::string_view symbol_name);
+
     private:
         MapType sym_map;
+        ClonesType clones;
+        MangledNameFilter filter;
+        std::ostream *log;
 
-        void FindWrappedSymbol(WrapperBase::Prototypes protos,
+        void FindWrappedSymbol(const WrapperBase::Prototypes &protos,
             const std::string &demangled, const char *symbol_name);
-        bool IsFunction(const char *symbol_name, const std::string &demangled);
+        void FindWrappedClone(const WrapperBase::Prototypes &protos,
+            const std::string &demangled, const char *symbol_name,
+            std::string::size_type clone_pos);
         bool IsSameFunction(const std::string &demangled,
             const PowerFake::internal::FunctionPrototype &proto);
-        std::string FunctionName(const std::string &demangled);
 };
 
 
@@ -0,0 +1,359 @@
+/*
+ * SymbolIndex.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "SymbolIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/core/demangle.hpp>
+
+#include "ArchiveFile.h"
+#include "ElfFile.h"
+#include "FileUtils.h"
+#include "SymbolAliasMap.h"
+
+using namespace std;
+
+namespace
+{
+const char INDEX_MAGIC[8] = { 'P', 'F', 'S', 'Y', 'M', 'I', 'D', 'X' };
+const uint32_t INDEX_VERSION = 2;
+}
+
+struct SymbolIndex::Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t member_count;
+    uint64_t symbol_count;
+    uint64_t members_offset;
+    uint64_t symbols_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    /// size and modification time (in ns) of the indexed library
+    uint64_t library_size;
+    int64_t library_mtime;
+};
+
+struct SymbolIndex::MemberRecord
+{
+    uint64_t hash;
+    uint32_t name;
+    uint32_t reserved;
+};
+
+struct SymbolIndex::SymbolRecord
+{
+    uint32_t key;
+    uint32_t demangled;
+    uint32_t mangled;
+    uint32_t member;
+};
+
+namespace
+{
+
+/**
+ * Deduplicated pool of NUL terminated strings
+ */
+class StringPool
+{
+    public:
+        StringPool() { pool += '\0'; offsets.emplace("", 0); }
+
+        uint32_t Add(string_view s)
+        {
+            auto o = offsets.find(string(s));
+            if (o != offsets.end())
+                return o->second;
+            if (pool.size() + s.size() + 1 > UINT32_MAX)
+                throw runtime_error("Symbol index string pool is too large");
+            uint32_t offset = pool.size();
+            pool += s;
+            pool += '\0';
+            offsets.emplace(string(s), offset);
+            return offset;
+        }
+
+        const string &Data() const { return pool; }
+
+    private:
+        string pool;
+        unordered_map<string, uint32_t> offsets;
+};
+
+struct LibraryMember
+{
+    string name;
+    string_view contents;
+};
+
+void Align(string &out)
+{
+    out.resize((out.size() + 7) & ~size_t(7), '\0');
+}
+
+}  // namespace
+
+
+SymbolIndex::~SymbolIndex()
+{
+    Close();
+}
+
+void SymbolIndex::Close()
+{
+    if (data)
+        munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = member_count = symbol_count = strings_size = library_size = 0;
+    library_mtime = 0;
+}
+
+bool SymbolIndex::Open(const std::string &file_name)
+{
+    Close();
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header))
+    {
+        close(fd);
+        return false;
+    }
+    void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return false;
+    data = static_cast<const char *>(mem);
+    size = st.st_size;
+
+    const Header *h = reinterpret_cast<const Header *>(data);
+    auto in_file = [this](uint64_t offset, uint64_t len) {
+        return offset <= size && len <= size - offset && offset % 8 == 0;
+    };
+    if (memcmp(h->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+            || h->version != INDEX_VERSION
+            || h->member_count > size || h->symbol_count > size
+            || !in_file(h->members_offset,
+                h->member_count * sizeof(MemberRecord))
+            || !in_file(h->symbols_offset,
+                h->symbol_count * sizeof(SymbolRecord))
+            || !in_file(h->strings_offset, h->strings_size)
+            || h->strings_size == 0
+            || data[h->strings_offset + h->strings_size - 1] != '\0')
+    {
+        Close();
+        return false;
+    }
+
+    members = reinterpret_cast<const MemberRecord *>(data + h->members_offset);
+    symbols = reinterpret_cast<const SymbolRecord *>(data + h->symbols_offset);
+    strings = data + h->strings_offset;
+    strings_size = h->strings_size;
+    library_size = h->library_size;
+    library_mtime = h->library_mtime;
+    member_count = h->member_count;
+    symbol_count = h->symbol_count;
+    return true;
+}
+
+std::string_view SymbolIndex::String(uint32_t offset) const
+{
+    if (offset >= strings_size)
+        throw runtime_error("Corrupted symbol index");
+    return string_view(strings + offset);
+}
+
+SymbolIndex::Entry SymbolIndex::At(size_t i) const
+{
+    const auto &s = symbols[i];
+    return Entry { String(s.key), String(s.demangled), String(s.mangled),
+        s.member };
+}
+
+std::pair<size_t, size_t> SymbolIndex::Find(std::string_view key) const
+{
+    auto key_less = [this](const SymbolRecord &s, string_view k) {
+        return String(s.key) < k;
+    };
+    auto first = lower_bound(symbols, symbols + symbol_count, key, key_less);
+    auto last = first;
+    while (last != symbols + symbol_count && String(last->key) == key)
+        ++last;
+    return make_pair(first - symbols, last - symbols);
+}
+
+std::string_view SymbolIndex::MemberName(size_t i) const
+{
+    return String(members[i].name);
+}
+
+uint64_t SymbolIndex::MemberHash(size_t i) const
+{
+    return members[i].hash;
+}
+
+SymbolIndex::UpdateResult SymbolIndex::Update(const std::string &index_file,
+    const std::string &library)
+{
+    UpdateResult result;
+    // the library is read and its members are hashed only if its size or
+    // modification time is changed
+    struct stat st;
+    if (stat(library.c_str(), &st) != 0)
+        throw runtime_error("Cannot read file: " + library);
+    const uint64_t lib_size = st.st_size;
+    const int64_t lib_mtime = int64_t(st.st_mtim.tv_sec) * 1000000000
+            + st.st_mtim.tv_nsec;
+
+    SymbolIndex old;
+    const bool old_valid = old.Open(index_file);
+    if (old_valid && old.library_size == lib_size
+            && old.library_mtime == lib_mtime)
+    {
+        result.reused_members = old.MemberCount();
+        return result;
+    }
+
+    const string contents = ReadFile(library);
+
+    // archive members, or the library itself if it is not an archive
+    vector<LibraryMember> lib_members;
+    unique_ptr<ArchiveFile> archive;
+    if (ArchiveFile::IsArchive(contents))
+    {
+        archive = make_unique<ArchiveFile>(contents);
+        map<string, int> seen;
+        for (const auto &m: archive->Members())
+        {
+            if (m.special)
+                continue;
+            // members with the same name are distinguished by their order
+            int n = seen[m.name]++;
+            lib_members.push_back(LibraryMember { n ? m.name + '#'
+                + to_string(n) : m.name, m.Contents() });
+        }
+    }
+    else
+        lib_members.push_back(LibraryMember {
+            library.substr(library.rfind('/') + 1), contents });
+
+    map<string_view, size_t> old_members;
+    vector<vector<size_t>> old_member_symbols;
+    if (old_valid)
+    {
+        old_member_symbols.resize(old.MemberCount());
+        for (size_t i = 0; i < old.MemberCount(); ++i)
+            old_members[old.MemberName(i)] = i;
+        for (size_t i = 0; i < old.Size(); ++i)
+            if (old.symbols[i].member < old.MemberCount())
+                old_member_symbols[old.symbols[i].member].push_back(i);
+    }
+
+    StringPool pool;
+    vector<MemberRecord> member_records;
+    vector<SymbolRecord> symbol_records;
+    // a changed time stamp is recorded, even if the contents are the same
+    bool changed = old.MemberCount() != lib_members.size()
+            || old.library_size != lib_size || old.library_mtime != lib_mtime;
+    for (size_t mi = 0; mi < lib_members.size(); ++mi)
+    {
+        const auto &m = lib_members[mi];
+        const uint64_t hash = ContentHash(m.contents);
+        member_records.push_back(MemberRecord { hash, pool.Add(m.name), 0 });
+
+        auto old_member = old_members.find(m.name);
+        if (old_member != old_members.end()
+                && old.MemberHash(old_member->second) == hash)
+        {
+            if (old_member->second != mi)
+                changed = true;
+            for (auto si: old_member_symbols[old_member->second])
+            {
+                auto e = old.At(si);
+                symbol_records.push_back(SymbolRecord { pool.Add(e.key),
+                    pool.Add(e.demangled), pool.Add(e.mangled),
+                    uint32_t(mi) });
+            }
+            ++result.reused_members;
+            continue;
+        }
+
+        changed = true;
+        ++result.scanned_members;
+        if (!ElfFile::IsSupported(m.contents))
+            continue;
+        ElfFile elf{string(m.contents)};
+        // imported symbols of shared objects are defined elsewhere
+        const bool shared = ElfFile::IsSharedObject(m.contents);
+        for (const auto &sym: elf.Symbols())
+        {
+            if (sym.type == STT_SECTION || sym.type == STT_FILE
+                    || (shared && sym.shndx == SHN_UNDEF))
+                continue;
+            const string mangled(sym.name);
+            const string demangled = boost::core::demangle(mangled.c_str());
+            const string key = SymbolAliasMap::IsFunction(mangled.c_str(),
+                demangled) ? SymbolAliasMap::FunctionName(demangled) : "";
+            symbol_records.push_back(SymbolRecord { pool.Add(key),
+                pool.Add(demangled), pool.Add(mangled), uint32_t(mi) });
+        }
+    }
+
+    if (!changed)
+        return result;
+
+    const string &strs = pool.Data();
+    sort(symbol_records.begin(), symbol_records.end(),
+        [&strs](const SymbolRecord &a, const SymbolRecord &b) {
+            auto str = [&strs](uint32_t o) { return string_view(&strs[o]); };
+            return make_tuple(str(a.key), str(a.mangled), a.member)
+                    < make_tuple(str(b.key), str(b.mangled), b.member);
+        });
+
+    string out(sizeof(Header), '\0');
+    Header h;
+    memcpy(h.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    h.version = INDEX_VERSION;
+    h.member_count = member_records.size();
+    h.symbol_count = symbol_records.size();
+    h.members_offset = out.size();
+    out.append(reinterpret_cast<const char *>(member_records.data()),
+        member_records.size() * sizeof(MemberRecord));
+    Align(out);
+    h.symbols_offset = out.size();
+    out.append(reinterpret_cast<const char *>(symbol_records.data()),
+        symbol_records.size() * sizeof(SymbolRecord));
+    Align(out);
+    h.strings_offset = out.size();
+    h.strings_size = strs.size();
+    h.library_size = lib_size;
+    h.library_mtime = lib_mtime;
+    out += strs;
+    memcpy(&out[0], &h, sizeof(h));
+
+    WriteFileAtomically(index_file, out);
+    result.written = true;
+    return result;
+}
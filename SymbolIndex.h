@@ -0,0 +1,105 @@
+/*
+ * SymbolIndex.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef SYMBOLINDEX_H_
+#define SYMBOLINDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * A persistent index of all symbols of a library, holding the mangled and
+ * demangled name of each symbol and its function name key as produced by
+ * SymbolAliasMap::FunctionName(). The index can be shared by all test targets
+ * linking the same library, so that its symbols are demangled only once.
+ *
+ * On disk, the index consists of a header, a member table, a symbol table
+ * sorted by function name key and a pool of NUL terminated strings. All
+ * tables are 8 byte aligned, so the file can be used directly through mmap().
+ */
+class SymbolIndex
+{
+    public:
+        struct Entry
+        {
+            std::string_view key;
+            std::string_view demangled;
+            /// NUL terminated in the underlying storage
+            std::string_view mangled;
+            uint32_t member;
+        };
+
+        struct UpdateResult
+        {
+            size_t reused_members = 0;
+            size_t scanned_members = 0;
+            bool written = false;
+        };
+
+    public:
+        SymbolIndex() = default;
+        SymbolIndex(const SymbolIndex &) = delete;
+        SymbolIndex &operator=(const SymbolIndex &) = delete;
+        ~SymbolIndex();
+
+        /**
+         * Maps index file @p file_name into memory
+         * @return false if the file does not exist or is not a valid index
+         */
+        bool Open(const std::string &file_name);
+
+        /**
+         * Creates or updates @p index_file for @p library, which can be an
+         * archive or a single ELF file. If the size and modification time of
+         * the library are not changed since the last update, the index is
+         * used as is without reading the library. Otherwise, symbols of
+         * archive members which are not changed are reused. The index file is
+         * replaced atomically, and only if it is changed.
+         */
+        static UpdateResult Update(const std::string &index_file,
+            const std::string &library);
+
+        size_t Size() const { return symbol_count; }
+        Entry At(size_t i) const;
+
+        /**
+         * @return range [first, second) of entries with the given key
+         */
+        std::pair<size_t, size_t> Find(std::string_view key) const;
+
+        size_t MemberCount() const { return member_count; }
+        std::string_view MemberName(size_t i) const;
+        uint64_t MemberHash(size_t i) const;
+
+    private:
+        struct Header;
+        struct MemberRecord;
+        struct SymbolRecord;
+
+        const char *data = nullptr;
+        size_t size = 0;
+        const MemberRecord *members = nullptr;
+        const SymbolRecord *symbols = nullptr;
+        const char *strings = nullptr;
+        size_t strings_size = 0;
+        uint64_t library_size = 0;
+        int64_t library_mtime = 0;
+        size_t member_count = 0;
+        size_t symbol_count = 0;
+
+        std::string_view String(uint32_t offset) const;
+        void Close();
+};
+
+#endif /* SYMBOLINDEX_H_ */
@@ -0,0 +1,263 @@
+/*
+ * SymbolPipeline.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "SymbolPipeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/core/demangle.hpp>
+
+#include "BindStats.h"
+#include "NMSymbolReader.h"
+#include "SymbolAliasMap.h"
+
+using namespace std;
+
+namespace
+{
+
+struct Batch
+{
+    size_t seq;
+    vector<string> symbols;
+    /// demangled form of candidate symbols, filled by workers
+    vector<string> demangled;
+};
+
+/// number of batches in the pipeline, which also bounds the batches waiting
+/// in each queue and to be matched in order
+const size_t BATCH_COUNT = 64;
+
+/**
+ * A blocking queue of batches. Consumers wait until a batch is available or
+ * the queue is closed. Aborting the queue wakes up everyone waiting on it.
+ */
+class BatchQueue
+{
+    public:
+        /**
+         * @return false if the queue is aborted
+         */
+        bool Push(unique_ptr<Batch> batch)
+        {
+            lock_guard<mutex> lock(m);
+            if (aborted)
+                return false;
+            batches.push_back(move(batch));
+            cv.notify_one();
+            return true;
+        }
+
+        /**
+         * @return the next batch, or nullptr if the queue is closed and empty
+         * or aborted
+         */
+        unique_ptr<Batch> Pop()
+        {
+            unique_lock<mutex> lock(m);
+            cv.wait(lock, [this]() {
+                return aborted || closed || !batches.empty(); });
+            if (aborted || batches.empty())
+                return nullptr;
+            auto batch = move(batches.front());
+            batches.pop_front();
+            return batch;
+        }
+
+        /**
+         * No more batches are pushed
+         */
+        void Close()
+        {
+            lock_guard<mutex> lock(m);
+            closed = true;
+            cv.notify_all();
+        }
+
+        void Abort()
+        {
+            lock_guard<mutex> lock(m);
+            aborted = true;
+            cv.notify_all();
+        }
+
+    private:
+        mutex m;
+        condition_variable cv;
+        deque<unique_ptr<Batch>> batches;
+        bool closed = false;
+        bool aborted = false;
+};
+
+}  // namespace
+
+
+SymbolPipeline::SymbolPipeline(SymbolAliasMap &symmap, unsigned workers,
+    size_t batch_size, BindStats *stats) :
+        symmap(symmap), workers(workers ? workers : 1),
+        batch_size(batch_size ? batch_size : 1), stats(stats)
+{
+}
+
+void SymbolPipeline::Run(NMSymbolReader &nm_reader)
+{
+    // The reader takes empty batches from free_queue, and matched batches are
+    // returned to it; so a fixed number of batches are in the pipeline and
+    // queues need no bounds
+    BatchQueue free_queue, read_queue, result_queue;
+    for (size_t i = 0; i < BATCH_COUNT; ++i)
+        free_queue.Push(make_unique<Batch>());
+
+    // the first error of any stage stops all of them
+    mutex error_mutex;
+    exception_ptr error;
+    auto abort = [&](exception_ptr e) {
+        {
+            lock_guard<mutex> lock(error_mutex);
+            if (!error)
+                error = e;
+        }
+        free_queue.Abort();
+        read_queue.Abort();
+        result_queue.Abort();
+    };
+
+    // Reader stage
+    thread reader([&]() {
+        BindStats::Timer timer;
+        size_t count = 0;
+        try
+        {
+            size_t seq = 0;
+            for (auto batch = free_queue.Pop(); batch;
+                    batch = free_queue.Pop())
+            {
+                timer.Start();
+                bool done = false;
+                while (batch->symbols.size() < batch_size)
+                {
+                    string_view symbol = nm_reader.NextSymbol();
+                    if ((done = symbol.empty()))
+                        break;
+                    batch->symbols.emplace_back(symbol);
+                }
+                count += batch->symbols.size();
+                timer.Stop();
+                batch->seq = seq++;
+                if (!read_queue.Push(move(batch)) || done)
+                    break;
+            }
+            read_queue.Close();
+        }
+        catch (...)
+        {
+            abort(current_exception());
+        }
+        if (stats)
+        {
+            stats->Add(BindStats::READ, timer, count);
+            stats->symbols += count;
+        }
+    });
+
+    // Demangling stage: only candidate symbols are kept and demangled
+    vector<thread> demanglers;
+    mutex workers_mutex;
+    unsigned active_workers = workers;
+    for (unsigned i = 0; i < workers; ++i)
+        demanglers.emplace_back([&]() {
+            BindStats::Timer timer;
+            size_t count = 0, candidates = 0;
+            try
+            {
+                while (auto batch = read_queue.Pop())
+                {
+                    timer.Start();
+                    count += batch->symbols.size();
+                    size_t kept = 0;
+                    for (auto &symbol: batch->symbols)
+                    {
+                        if (!symmap.IsCandidate(symbol.c_str()))
+                            continue;
+                        batch->demangled.push_back(
+                            boost::core::demangle(symbol.c_str()));
+                        batch->symbols[kept++] = move(symbol);
+                    }
+                    batch->symbols.resize(kept);
+                    candidates += kept;
+                    timer.Stop();
+                    if (!result_queue.Push(move(batch)))
+                        break;
+                }
+            }
+            catch (...)
+            {
+                abort(current_exception());
+            }
+            if (stats)
+            {
+                stats->Add(BindStats::DEMANGLE, timer, count);
+                stats->candidates += candidates;
+            }
+            lock_guard<mutex> lock(workers_mutex);
+            if (--active_workers == 0)
+                result_queue.Close();
+        });
+
+    // Matching stage, processing batches in their original order. At most
+    // BATCH_COUNT batches can be pending.
+    map<size_t, unique_ptr<Batch>> pending;
+    size_t next_seq = 0;
+    BindStats::Timer match_timer;
+    size_t match_count = 0;
+    try
+    {
+        while (auto batch = result_queue.Pop())
+        {
+            const size_t seq = batch->seq;
+            pending.emplace(seq, move(batch));
+            for (auto p = pending.begin();
+                    p != pending.end() && p->first == next_seq;
+                    p = pending.erase(p), ++next_seq)
+            {
+                auto &b = *p->second;
+                match_timer.Start();
+                for (size_t i = 0; i < b.symbols.size(); ++i)
+                    symmap.AddSymbol(b.symbols[i].c_str(), b.demangled[i]);
+                match_timer.Stop();
+                match_count += b.symbols.size();
+                b.symbols.clear();
+                b.demangled.clear();
+                free_queue.Push(move(p->second));
+            }
+        }
+    }
+    catch (...)
+    {
+        abort(current_exception());
+    }
+    if (stats)
+        stats->Add(BindStats::MATCH, match_timer, match_count);
+
+    reader.join();
+    for (auto &t: demanglers)
+        t.join();
+    if (error)
+        rethrow_exception(error);
+}
@@ -0,0 +1,58 @@
+/*
+ * SymbolPipeline.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef SYMBOLPIPELINE_H_
+#define SYMBOLPIPELINE_H_
+
+#include <cstddef>
+
+class BindStats;
+class NMSymbolReader;
+class SymbolAliasMap;
+
+/**
+ * Feeds symbols read by a NMSymbolReader into a SymbolAliasMap using a staged
+ * pipeline: a reader thread collects symbols into batches, several worker
+ * threads filter and demangle them, and the calling thread matches them
+ * against wrapped functions. Stages are connected by blocking queues, and a
+ * fixed number of batches are recycled through them, which bounds the memory
+ * used by the pipeline.
+ *
+ * Batches are matched in the order they are read, so the results are the same
+ * as calling SymbolAliasMap::AddSymbol() for each symbol in order.
+ */
+class SymbolPipeline
+{
+    public:
+        /**
+         * @param symmap the map receiving symbols
+         * @param workers number of demangling threads
+         * @param batch_size number of symbols passed between stages at once
+         * @param stats if not nullptr, receives busy time of each stage
+         * (excluding time spent waiting for other stages)
+         */
+        SymbolPipeline(SymbolAliasMap &symmap, unsigned workers,
+            size_t batch_size = 1024, BindStats *stats = nullptr);
+
+        /**
+         * Reads all symbols from @p nm_reader and adds them to the map
+         */
+        void Run(NMSymbolReader &nm_reader);
+
+    private:
+        SymbolAliasMap &symmap;
+        unsigned workers;
+        size_t batch_size;
+        BindStats *stats;
+};
+
+#endif /* SYMBOLPIPELINE_H_ */
@@ -0,0 +1,114 @@
+/*
+ * SymbolRenamer.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "SymbolRenamer.h"
+
+#include <map>
+
+#include "ArchiveFile.h"
+#include "FileUtils.h"
+
+using namespace std;
+
+
+SymbolRenamer::SymbolRenamer(ElfFile::RenameMap renames) :
+        renames(move(renames))
+{
+}
+
+bool SymbolRenamer::IsSupported(const std::string &file_name)
+{
+    string head = ReadFileHead(file_name, 16);
+    return ArchiveFile::IsArchive(head) || ElfFile::IsSupported(head);
+}
+
+size_t SymbolRenamer::RenameFile(const std::string &file_name) const
+{
+    string contents = ReadFile(file_name);
+    size_t renamed = Rename(contents);
+    if (renamed)
+        WriteFileAtomically(file_name, contents);
+    return renamed;
+}
+
+size_t SymbolRenamer::Rename(std::string &contents) const
+{
+    if (!ArchiveFile::IsArchive(contents))
+    {
+        ElfFile elf(move(contents));
+        size_t renamed = elf.RenameSymbols(renames);
+        contents = elf.Release();
+        return renamed;
+    }
+
+    ArchiveFile archive(contents);
+    size_t renamed = 0;
+    for (auto &member: archive.Members())
+    {
+        if (member.special || !ElfFile::IsSupported(member.Contents()))
+            continue;
+        ElfFile elf{string(member.Contents())};
+        size_t member_renamed = elf.RenameSymbols(renames);
+        if (member_renamed)
+        {
+            archive.SetContents(member, elf.Release());
+            renamed += member_renamed;
+        }
+    }
+    if (renamed)
+    {
+        archive.RenameIndexSymbols(renames);
+        contents = archive.Serialize();
+    }
+    return renamed;
+}
+
+std::vector<std::string> SymbolRenamer::CopyRenamed(
+    const std::string &file_name, const std::string &output_dir) const
+{
+    const string base_name = file_name.substr(file_name.rfind('/') + 1);
+    string contents = ReadFile(file_name);
+    vector<string> copies;
+    if (!ArchiveFile::IsArchive(contents))
+    {
+        if (Rename(contents))
+        {
+            CreateDirectories(output_dir);
+            copies.push_back(output_dir + '/' + base_name);
+            WriteFileIfChanged(copies.back(), contents);
+        }
+        return copies;
+    }
+
+    const string member_dir = output_dir + '/' + base_name;
+    ArchiveFile archive(move(contents));
+    map<string, int> seen;
+    for (auto &member: archive.Members())
+    {
+        if (member.special)
+            continue;
+        // members with the same name are distinguished by their order
+        int n = seen[member.name]++;
+        if (!ElfFile::IsSupported(member.Contents()))
+            continue;
+        ElfFile elf{string(member.Contents())};
+        if (!elf.RenameSymbols(renames))
+            continue;
+
+        if (copies.empty())
+            CreateDirectories(member_dir);
+        copies.push_back(member_dir + '/' + member.name
+            + (n ? '.' + to_string(n) : ""));
+        WriteFileIfChanged(copies.back(), elf.Release());
+    }
+    return copies;
+}
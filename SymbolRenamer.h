@@ -0,0 +1,65 @@
+/*
+ * SymbolRenamer.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef SYMBOLRENAMER_H_
+#define SYMBOLRENAMER_H_
+
+#include <string>
+#include <vector>
+
+#include "ElfFile.h"
+
+/**
+ * Renames symbols of ELF object files and of all ELF members of static
+ * libraries in-process, as a replacement for running
+ * 'objcopy --redefine-sym ...' for each file.
+ */
+class SymbolRenamer
+{
+    public:
+        explicit SymbolRenamer(ElfFile::RenameMap renames);
+
+        /**
+         * @return true if @p file_name is an ELF object or an archive which can
+         * be processed by RenameFile()
+         */
+        static bool IsSupported(const std::string &file_name);
+
+        /**
+         * Renames symbols in @p file_name. The file is only rewritten if some
+         * symbols are renamed, and it is replaced atomically.
+         * @return number of renamed symbols
+         */
+        size_t RenameFile(const std::string &file_name) const;
+
+        /**
+         * Renames symbols of an in-memory object file or archive
+         * @return number of renamed symbols
+         */
+        size_t Rename(std::string &contents) const;
+
+        /**
+         * Writes renamed copies of @p file_name into @p output_dir, leaving
+         * the file itself untouched. Each archive member having renamed
+         * symbols is written as <output_dir>/<archive name>/<member name>,
+         * and an object file as <output_dir>/<file name>. Copies are only
+         * rewritten if changed.
+         * @return paths of written (or unchanged) copies
+         */
+        std::vector<std::string> CopyRenamed(const std::string &file_name,
+            const std::string &output_dir) const;
+
+    private:
+        ElfFile::RenameMap renames;
+};
+
+#endif /* SYMBOLRENAMER_H_ */
@@ -0,0 +1,132 @@
+/*
+ * WrapperShards.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "WrapperShards.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "FileUtils.h"
+
+using namespace std;
+
+namespace
+{
+
+string Trim(const string &s)
+{
+    auto start = s.find_first_not_of(" \t\r");
+    if (start == string::npos)
+        return string();
+    return s.substr(start, s.find_last_not_of(" \t\r") - start + 1);
+}
+
+/// @return change of parentheses depth in @p s
+int ParenBalance(const string &s)
+{
+    int balance = 0;
+    for (char c: s)
+        if (c == '(')
+            ++balance;
+        else if (c == ')')
+            --balance;
+    return balance;
+}
+
+}  // namespace
+
+
+void WrapperShards::Read(std::istream &in)
+{
+    string line;
+    string wrapper;
+    int depth = 0;
+    while (getline(in, line))
+    {
+        line = Trim(line);
+        if (wrapper.empty() && (line.empty() || line.compare(0, 2, "//") == 0))
+            continue;
+        if (wrapper.empty() && line.compare(0, 5, "WRAP_") != 0)
+        {
+            preamble.push_back(line);
+            continue;
+        }
+
+        if (!wrapper.empty())
+            wrapper += ' ';
+        wrapper += line;
+        depth += ParenBalance(line);
+        if (depth > 0)
+            continue;
+        if (wrapper.back() != ';')
+            wrapper += ';';
+        wrappers.push_back(move(wrapper));
+        wrapper.clear();
+        depth = 0;
+    }
+    if (!wrapper.empty())
+        throw runtime_error("Incomplete wrapper definition: " + wrapper);
+}
+
+std::vector<std::string> WrapperShards::Sources(size_t count,
+    const std::string &wrap_namespace) const
+{
+    vector<ostringstream> sources(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        sources[i] << "// Generated by bind_fakes, do not edit\n"
+                << "#include <powerfake.h>\n\n";
+        for (const auto &line: preamble)
+            sources[i] << line << '\n';
+        sources[i] << "\n#undef POWRFAKE_WRAP_NAMESPACE\n"
+                << "#define POWRFAKE_WRAP_NAMESPACE " << wrap_namespace << i
+                << "\n\n";
+    }
+    // each wrapper is in its own line, as aliases are built using __LINE__
+    for (const auto &wrapper: wrappers)
+        sources[ContentHash(wrapper) % count] << wrapper << '\n';
+
+    vector<string> result;
+    for (auto &src: sources)
+        result.push_back(src.str());
+    return result;
+}
+
+size_t WrapperShards::Write(const std::string &list_file, size_t count,
+    const std::string &output_prefix)
+{
+    if (count == 0)
+        throw runtime_error("At least one wrapper source is needed");
+    ifstream in(list_file);
+    if (!in)
+        throw runtime_error("Cannot open wrapper list: " + list_file);
+    WrapperShards shards;
+    shards.Read(in);
+
+    // namespace is based on the output file name, which should be unique
+    string wrap_namespace = output_prefix.substr(
+        output_prefix.find_last_of('/') + 1);
+    for (char &c: wrap_namespace)
+        if (!isalnum(static_cast<unsigned char>(c)))
+            c = '_';
+    wrap_namespace = "PowerFake_" + wrap_namespace;
+
+    size_t written = 0;
+    auto sources = shards.Sources(count, wrap_namespace);
+    for (size_t i = 0; i < count; ++i)
+        if (WriteFileIfChanged(output_prefix + to_string(i) + ".cpp",
+                sources[i]))
+            ++written;
+    return written;
+}
@@ -0,0 +1,64 @@
+/*
+ * WrapperShards.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef WRAPPERSHARDS_H_
+#define WRAPPERSHARDS_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * Splits a list of wrapped functions into several wrapper source files, so
+ * that they can be compiled in parallel. The list contains WRAP_*() macro
+ * invocations (one or more lines each), and other lines (e.g. #include lines
+ * and using declarations) which are copied to the start of every source.
+ * Lines starting with // and empty lines are ignored.
+ *
+ * Each source gets its own POWRFAKE_WRAP_NAMESPACE, so aliases never collide.
+ * Wrappers are assigned to sources by the hash of their text, so adding or
+ * removing a wrapper only changes one source.
+ */
+class WrapperShards
+{
+    public:
+        /**
+         * Reads the list of wrapped functions from @p in
+         * @throw std::runtime_error if a WRAP_*() invocation is not complete
+         */
+        void Read(std::istream &in);
+
+        /**
+         * @return @p count wrapper sources, using @p wrap_namespace followed
+         * by source index as POWRFAKE_WRAP_NAMESPACE
+         */
+        std::vector<std::string> Sources(size_t count,
+            const std::string &wrap_namespace) const;
+
+        /**
+         * Writes @p count sources of wrappers listed in @p list_file into
+         * <output_prefix><index>.cpp, if their contents are changed
+         * @return number of written files
+         * @throw std::runtime_error on failure
+         */
+        static size_t Write(const std::string &list_file, size_t count,
+            const std::string &output_prefix);
+
+        const std::vector<std::string> &Preamble() const { return preamble; }
+        const std::vector<std::string> &Wrappers() const { return wrappers; }
+
+    private:
+        std::vector<std::string> preamble;
+        std::vector<std::string> wrappers;
+};
+
+#endif /* WRAPPERSHARDS_H_ */
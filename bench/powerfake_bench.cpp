@@ -0,0 +1,688 @@
+/*
+ * powerfake_bench.cpp
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/*
+ * Scaling benchmark helper for bind_fakes. It has these commands:
+ *
+ *  generate <out_dir> <symbols> <lib_files> <wraps> <wrap_files>
+ *      Generates sources of a synthetic library with about <symbols> symbols
+ *      when compiled without optimization, in <lib_files> files, and <wrap_files> files with <wraps> wrapped
+ *      functions of that library.
+ *
+ *  run <repeat> <work_dir> <bind_fakes_helper> <base_lib> <wrapper_lib>
+ *      Runs the bind_fakes helper in different modes <repeat> times each, and
+ *      reports the best end to end time and the time of each phase reported
+ *      by --stats-json.
+ *
+ *  link <repeat> <output> <linkers> <link_command>...
+ *      Runs the link command with each of the comma separated <linkers> (e.g.
+ *      bfd,gold,lld) given to -fuse-ld, <repeat> times each, and reports
+ *      the best time and the size of the output. Linkers which fail, e.g. as
+ *      they are not installed, are reported as unavailable.
+ *
+ *  scale <repeat> <work_dir> <bind_fakes> <base_lib> <wrapper_lib>
+ *          <powerfake_lib> <main_obj> <compile_command>... -- <wrap_sources>...
+ *      Measures the whole flow of a test binary: compiling wrapper sources,
+ *      bind_fakes, linking, binary size and the CPU time before main() (which
+ *      main_obj prints), in objcopy and --no-objcopy modes. A binary without
+ *      wrappers is linked as the baseline.
+ *
+ *  size <work_dir> <compile_command>... -- <wrap_sources>...
+ *      Compiles wrapper sources with normal and compact wrappers
+ *      (POWERFAKE_COMPACT_WRAPPERS), and reports the code and data size of
+ *      the resulting objects per wrapped function.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+
+/// approximate number of symbols generated for each unit, measured with GCC
+/// without optimization (nm -po output of a library, including shared template
+/// instances); optimized builds have much fewer symbols, so the actual count
+/// is measured by the run and scale commands
+const size_t SYMBOLS_PER_UNIT = 45;
+
+/// number of different kinds of wrapped functions in each unit
+const size_t WRAP_KINDS = 7;
+
+const char *const phases[] = { "read", "demangle", "match", "rename",
+    "link_flags", "total" };
+
+void WriteFile(const string &path, const string &contents)
+{
+    ofstream out(path);
+    out << contents;
+    if (!out)
+        throw runtime_error("Cannot write file: " + path);
+}
+
+/**
+ * Declarations of each unit. Units use heavy templates, abi tags, operators
+ * and static locals to get symbols similar to real world C++ libraries.
+ */
+string UnitDeclaration(size_t u)
+{
+    ostringstream s;
+    s << "int func" << u << "(int a);\n"
+      << "std::string func" << u << "(const std::string &s);\n"
+      << "[[gnu::abi_tag(\"bench\")]] std::string tagged" << u << "(int a);\n"
+      << "struct Class" << u << "\n{\n"
+      << "    int Method(int a) const;\n"
+      << "    Class" << u << " &operator+=(const Class" << u << " &o);\n"
+      << "    static int Counter();\n"
+      << "    int v = 0;\n"
+      << "};\n"
+      << "template <typename T> struct Tmpl" << u << "\n{\n"
+      << "    T Get(const std::map<std::string, std::vector<T>> &m) const;\n"
+      << "};\n"
+      << "extern template struct Tmpl" << u << "<int>;\n"
+      << "extern template struct Tmpl" << u << "<Class" << u << ">;\n\n";
+    return s.str();
+}
+
+string UnitDefinition(size_t u)
+{
+    ostringstream s;
+    s << "int func" << u << "(int a) { return a + " << u << "; }\n"
+      << "std::string func" << u << "(const std::string &s) { return s + \""
+      << u << "\"; }\n"
+      << "std::string tagged" << u << "(int a) { return std::to_string(a); }\n"
+      << "int Class" << u << "::Method(int a) const { return v + a; }\n"
+      << "Class" << u << " &Class" << u << "::operator+=(const Class" << u
+      << " &o) { v += o.v; return *this; }\n"
+      << "int Class" << u << "::Counter()\n{\n"
+      << "    static std::map<int, std::string> local{{" << u << ", \"u\"}};\n"
+      << "    return local.size();\n}\n"
+      << "template <typename T>\n"
+      << "T Tmpl" << u << "<T>::Get(\n"
+      << "    const std::map<std::string, std::vector<T>> &m) const\n{\n"
+      << "    auto i = m.find(\"" << u << "\");\n"
+      << "    return i == m.end() || i->second.empty() ? T()"
+      << " : i->second.front();\n}\n"
+      << "template struct Tmpl" << u << "<int>;\n"
+      << "template struct Tmpl" << u << "<Class" << u << ">;\n\n";
+    return s.str();
+}
+
+string WrapDeclaration(size_t u, size_t kind)
+{
+    ostringstream s;
+    const string ns = "bench::ns" + to_string(u) + "::";
+    switch (kind)
+    {
+        case 0:
+            s << "WRAP_FUNCTION(int (int), " << ns << "func" << u << ");";
+            break;
+        case 1:
+            s << "WRAP_FUNCTION(std::string (const std::string &), " << ns
+                    << "func" << u << ");";
+            break;
+        case 2:
+            s << "WRAP_FUNCTION(" << ns << "tagged" << u << ");";
+            break;
+        case 3:
+            s << "WRAP_FUNCTION(" << ns << "Class" << u << "::Method);";
+            break;
+        case 4:
+            s << "WRAP_FUNCTION(" << ns << "Class" << u << "::operator+=);";
+            break;
+        case 5:
+            s << "WRAP_STATIC_MEMBER(" << ns << "Class" << u << ", " << ns
+                    << "Class" << u << "::Counter);";
+            break;
+        default:
+            s << "WRAP_FUNCTION(" << ns << "Tmpl" << u << "<int>::Get);";
+    }
+    return s.str();
+}
+
+void Generate(const string &dir, size_t symbols, size_t lib_files,
+    size_t wraps, size_t wrap_files)
+{
+    const size_t units = max<size_t>(1, symbols / SYMBOLS_PER_UNIT);
+    if (wraps > units * WRAP_KINDS)
+        throw runtime_error("Too many wraps for the number of symbols");
+
+    // each unit lives in its own namespace, so the header can be split by
+    // library file
+    ostringstream header;
+    header << "// Generated by powerfake_bench, do not edit\n"
+            << "#ifndef BENCH_LIB_H_\n#define BENCH_LIB_H_\n\n"
+            << "#include <map>\n#include <string>\n#include <vector>\n\n";
+    for (size_t u = 0; u < units; ++u)
+        header << "namespace bench { namespace ns" << u << " {\n"
+                << UnitDeclaration(u) << "} }\n";
+    header << "#endif\n";
+    WriteFile(dir + "/bench_lib.h", header.str());
+
+    for (size_t f = 0; f < lib_files; ++f)
+    {
+        ostringstream src;
+        src << "// Generated by powerfake_bench, do not edit\n"
+                << "#include \"bench_lib.h\"\n\n";
+        for (size_t u = f; u < units; u += lib_files)
+            src << "namespace bench { namespace ns" << u << " {\n"
+                    << UnitDefinition(u) << "} }\n";
+        WriteFile(dir + "/lib_" + to_string(f) + ".cpp", src.str());
+    }
+
+    // wrapped functions are spread over all units
+    const size_t wrapped_units = (wraps + WRAP_KINDS - 1) / WRAP_KINDS;
+    const size_t step = max<size_t>(1, units / max<size_t>(1, wrapped_units));
+    vector<ostringstream> wrap_srcs(wrap_files);
+    for (size_t f = 0; f < wrap_files; ++f)
+        wrap_srcs[f] << "// Generated by powerfake_bench, do not edit\n"
+                << "#include <powerfake.h>\n\n#include \"bench_lib.h\"\n\n"
+                << "#undef POWRFAKE_WRAP_NAMESPACE\n"
+                << "#define POWRFAKE_WRAP_NAMESPACE BenchWrap" << f << "\n\n";
+    for (size_t w = 0; w < wraps; ++w)
+        wrap_srcs[w % wrap_files] << WrapDeclaration(
+            (w / WRAP_KINDS * step) % units, w % WRAP_KINDS) << '\n';
+    for (size_t f = 0; f < wrap_files; ++f)
+        WriteFile(dir + "/wrap_" + to_string(f) + ".cpp", wrap_srcs[f].str());
+
+    cout << "Generated " << units << " units (~" << units * SYMBOLS_PER_UNIT
+            << " symbols without optimization) in " << lib_files << " files, "
+            << wraps
+            << " wraps in " << wrap_files << " files" << endl;
+}
+
+/**
+ * Runs @p args, discarding its output
+ * @return elapsed wall time in seconds
+ */
+double Run(const vector<string> &args)
+{
+    auto start = chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid < 0)
+        throw runtime_error("fork() failed");
+    if (pid == 0)
+    {
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        vector<char *> argv;
+        for (const auto &a: args)
+            argv.push_back(const_cast<char *>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw runtime_error("Running " + args[0] + " failed");
+    return chrono::duration<double>(chrono::steady_clock::now() - start)
+            .count();
+}
+
+/**
+ * Runs @p args
+ * @return its standard output
+ */
+string RunOutput(const vector<string> &args)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        throw runtime_error("pipe() failed");
+    pid_t pid = fork();
+    if (pid < 0)
+        throw runtime_error("fork() failed");
+    if (pid == 0)
+    {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        vector<char *> argv;
+        for (const auto &a: args)
+            argv.push_back(const_cast<char *>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    string output;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+        output.append(buf, n);
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw runtime_error("Running " + args[0] + " failed");
+    return output;
+}
+
+/**
+ * @return number of symbols of @p lib, as listed by nm (and read by
+ * bind_fakes)
+ */
+size_t CountSymbols(const string &lib)
+{
+    const string symbols = RunOutput({ "/usr/bin/env", "nm", "-po", lib });
+    return count(symbols.begin(), symbols.end(), '\n');
+}
+
+void CopyFile(const string &from, const string &to)
+{
+    ifstream in(from, ios::binary);
+    ofstream out(to, ios::binary);
+    out << in.rdbuf();
+    if (!in || !out)
+        throw runtime_error("Cannot copy " + from + " to " + to);
+}
+
+/**
+ * Extracts the value of @p field from stats JSON, after the start of
+ * @p object if given
+ */
+double JsonValue(const string &json, const string &field,
+    const string &object = string())
+{
+    size_t p = 0;
+    if (!object.empty() && (p = json.find('"' + object + "\": {"))
+            == string::npos)
+        return 0;
+    p = json.find('"' + field + "\": ", p);
+    if (p == string::npos)
+        return 0;
+    return strtod(json.c_str() + p + field.size() + 4, nullptr);
+}
+
+void RunBenchmark(unsigned repeat, const string &work_dir,
+    const string &helper, const string &base_lib, const string &wrapper_lib)
+{
+    struct Mode
+    {
+        string name;
+        vector<string> options;
+        /// files removed before each run
+        vector<string> cold_files;
+    };
+    const string index = work_dir + "/bench.powerfake_index";
+    const string cache = work_dir + "/bench.powerfake_cache";
+    const Mode modes[] = {
+        { "nm serial", { "--jobs", "1" }, {} },
+        { "nm pipeline", { "--jobs", to_string(max(2u,
+            thread::hardware_concurrency())) }, {} },
+        { "index cold", { "--symbol-index", index }, { index } },
+        { "index warm", { "--symbol-index", index }, {} },
+        { "cache replay", { "--cache", cache }, {} },
+    };
+
+    const string wrapper_copy = work_dir + "/bench_wrapper.a";
+    const string stats_file = work_dir + "/bench_stats.json";
+    if (chdir(work_dir.c_str()) != 0)
+        throw runtime_error("Cannot change directory to: " + work_dir);
+
+    cout << "base library: " << CountSymbols(base_lib) << " symbols\n";
+
+    cout << left << setw(14) << "mode" << right << setw(10) << "e2e(s)";
+    for (auto phase: phases)
+        cout << setw(12) << phase;
+    cout << setw(10) << "symbols" << setw(8) << "cands" << '\n' << fixed
+            << setprecision(3);
+    for (const auto &mode: modes)
+    {
+        double best = 0;
+        string best_stats;
+        for (unsigned r = 0; r < repeat; ++r)
+        {
+            for (const auto &f: mode.cold_files)
+                remove(f.c_str());
+            // the wrapper library is modified by bind_fakes
+            CopyFile(wrapper_lib, wrapper_copy);
+            vector<string> args = { helper, "--stats-json", stats_file };
+            args.insert(args.end(), mode.options.begin(), mode.options.end());
+            args.push_back(base_lib);
+            args.push_back(wrapper_copy);
+            // for cache replay, the cache is filled by the first run
+            if (mode.name == "cache replay" && r == 0)
+                Run(args);
+
+            double t = Run(args);
+            if (r == 0 || t < best)
+            {
+                best = t;
+                ifstream in(stats_file);
+                best_stats.assign(istreambuf_iterator<char>(in),
+                    istreambuf_iterator<char>());
+            }
+        }
+        cout << left << setw(14) << mode.name << right << setw(10) << best;
+        for (auto phase: phases)
+            cout << setw(12) << JsonValue(best_stats, "wall", phase);
+        cout << setprecision(0) << setw(10) << JsonValue(best_stats, "symbols")
+                << setw(8) << JsonValue(best_stats, "candidates")
+                << setprecision(3) << endl;
+    }
+}
+
+size_t FileSize(const string &file)
+{
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0)
+        throw runtime_error("Cannot find file: " + file);
+    return st.st_size;
+}
+
+void RunLinkBenchmark(unsigned repeat, const string &output,
+    const string &linkers, const vector<string> &command)
+{
+    cout << left << setw(8) << "linker" << right << setw(10) << "link(s)"
+            << setw(14) << "size" << '\n' << fixed << setprecision(3);
+    istringstream linker_list(linkers);
+    string linker;
+    while (getline(linker_list, linker, ','))
+    {
+        if (linker.empty())
+            continue;
+        vector<string> args(command);
+        args.push_back("-fuse-ld=" + linker);
+        args.push_back("-o");
+        args.push_back(output);
+
+        double best = 0;
+        try
+        {
+            for (unsigned r = 0; r < repeat; ++r)
+            {
+                remove(output.c_str());
+                double t = Run(args);
+                if (r == 0 || t < best)
+                    best = t;
+            }
+        }
+        catch (runtime_error &)
+        {
+            cout << left << setw(8) << linker << right << setw(10)
+                    << "unavailable" << endl;
+            continue;
+        }
+        cout << left << setw(8) << linker << right << setw(10) << best
+                << setw(14) << FileSize(output) << endl;
+    }
+}
+
+void RunScaleBenchmark(unsigned repeat, const string &work_dir,
+    const string &bind_fakes, const string &base_lib,
+    const string &wrapper_lib, const string &powerfake_lib,
+    const string &main_obj, const vector<string> &compile_command,
+    const vector<string> &wrap_sources)
+{
+    const string &compiler = compile_command.front();
+    const string stats_file = work_dir + "/scale_stats.json";
+    const string index = work_dir + "/scale.powerfake_index";
+    if (chdir(work_dir.c_str()) != 0)
+        throw runtime_error("Cannot change directory to: " + work_dir);
+    cout << "base library: " << CountSymbols(base_lib) << " symbols" << endl;
+
+    // wrapper sources are compiled one by one, like a serial build
+    double compile = 0;
+    for (unsigned r = 0; r < repeat; ++r)
+    {
+        double t = 0;
+        for (const auto &src: wrap_sources)
+        {
+            vector<string> args(compile_command);
+            args.insert(args.end(), { "-c", src, "-o", work_dir + "/wrap.o" });
+            t += Run(args);
+        }
+        if (r == 0 || t < compile)
+            compile = t;
+    }
+
+    struct Mode
+    {
+        string name;
+        vector<string> bind_options;
+        vector<string> link_inputs;
+    };
+    // in objcopy mode, renamed copies of wrapper objects are linked through
+    // link flags; otherwise all wrapper objects should be linked explicitly
+    const Mode modes[] = {
+        { "baseline", {}, {} },
+        { "objcopy", { "--output-dir", work_dir + "/objects" },
+            { wrapper_lib } },
+        { "defsym", { "--no-objcopy" }, { "-Wl,--whole-archive", wrapper_lib,
+            "-Wl,--no-whole-archive" } },
+    };
+
+    size_t wraps = 0;
+    cout << left << setw(10) << "mode" << right << setw(10) << "bind(s)"
+            << setw(10) << "link(s)" << setw(14) << "size" << setw(12)
+            << "init(ms)" << '\n' << fixed << setprecision(3);
+    for (const auto &mode: modes)
+    {
+        const bool baseline = mode.name == "baseline";
+        const string flags = work_dir + "/" + mode.name + ".link_flags";
+        const string output = work_dir + "/" + mode.name + "_test";
+        double bind = 0, link = 0, init = 0;
+        for (unsigned r = 0; r < repeat; ++r)
+        {
+            if (!baseline)
+            {
+                // symbol index is created in each run, as in a clean build
+                remove(index.c_str());
+                vector<string> args = { bind_fakes, "--stats-json",
+                    stats_file, "--symbol-index", index, "--link-flags",
+                    flags };
+                args.insert(args.end(), mode.bind_options.begin(),
+                    mode.bind_options.end());
+                args.push_back(base_lib);
+                args.push_back(wrapper_lib);
+                double t = Run(args);
+                if (r == 0 || t < bind)
+                    bind = t;
+            }
+
+            vector<string> args = { compiler, main_obj };
+            if (!baseline)
+                args.push_back("@" + flags);
+            args.insert(args.end(), mode.link_inputs.begin(),
+                mode.link_inputs.end());
+            args.insert(args.end(), { base_lib, powerfake_lib, "-o", output });
+            double t = Run(args);
+            if (r == 0 || t < link)
+                link = t;
+
+            double cpu_ns = stod(RunOutput({ output }));
+            if (r == 0 || cpu_ns / 1e6 < init)
+                init = cpu_ns / 1e6;
+        }
+        if (!baseline)
+        {
+            ifstream in(stats_file);
+            wraps = JsonValue(string(istreambuf_iterator<char>(in),
+                istreambuf_iterator<char>()), "matched");
+        }
+        cout << left << setw(10) << mode.name << right << setw(10) << bind
+                << setw(10) << link << setw(14) << FileSize(output)
+                << setw(12) << init << endl;
+    }
+    cout << "wrapper compilation: " << compile << "s in "
+            << wrap_sources.size() << " files, " << setprecision(1)
+            << (wraps ? compile * 1000 / wraps : 0) << "ms per wrap; "
+            << wraps << " wraps" << setprecision(3) << endl;
+}
+
+/**
+ * Size of loaded sections of a 64 bit ELF object file, and the number of
+ * wrapper functions defined in it
+ */
+struct ObjectSize
+{
+    size_t code = 0;
+    size_t data = 0;
+    size_t wrappers = 0;
+};
+
+ObjectSize ReadObjectSize(const string &file)
+{
+    ifstream in(file, ios::binary);
+    const string elf((istreambuf_iterator<char>(in)),
+        istreambuf_iterator<char>());
+    Elf64_Ehdr ehdr;
+    if (elf.size() < sizeof(ehdr) || elf.compare(0, SELFMAG, ELFMAG) != 0
+            || elf[EI_CLASS] != ELFCLASS64)
+        throw runtime_error("Not a 64 bit ELF file: " + file);
+    memcpy(&ehdr, elf.data(), sizeof(ehdr));
+
+    auto section = [&elf, &ehdr](size_t i) {
+        Elf64_Shdr shdr;
+        memcpy(&shdr, elf.data() + ehdr.e_shoff + i * ehdr.e_shentsize,
+            sizeof(shdr));
+        return shdr;
+    };
+    ObjectSize size;
+    for (size_t i = 0; i < ehdr.e_shnum; ++i)
+    {
+        auto shdr = section(i);
+        if (shdr.sh_flags & SHF_EXECINSTR)
+            size.code += shdr.sh_size;
+        else if (shdr.sh_flags & SHF_ALLOC)
+            size.data += shdr.sh_size;
+        else if (shdr.sh_type == SHT_SYMTAB)
+        {
+            const char *strtab = elf.data() + section(shdr.sh_link).sh_offset;
+            for (size_t off = 0; off + sizeof(Elf64_Sym) <= shdr.sh_size;
+                    off += sizeof(Elf64_Sym))
+            {
+                Elf64_Sym sym;
+                memcpy(&sym, elf.data() + shdr.sh_offset + off, sizeof(sym));
+                if (sym.st_shndx != SHN_UNDEF && ELF64_ST_TYPE(sym.st_info)
+                        == STT_FUNC && strstr(strtab + sym.st_name,
+                        "__wrap_function_"))
+                    ++size.wrappers;
+            }
+        }
+    }
+    return size;
+}
+
+void RunSizeBenchmark(const string &work_dir,
+    const vector<string> &compile_command, const vector<string> &wrap_sources)
+{
+    const char *const modes[] = { "normal", "compact" };
+    ObjectSize sizes[2];
+    for (int m = 0; m < 2; ++m)
+    {
+        for (const auto &src: wrap_sources)
+        {
+            const string obj = work_dir + "/wrap_" + modes[m] + ".o";
+            vector<string> args(compile_command);
+            if (m == 1)
+                args.push_back("-DPOWERFAKE_COMPACT_WRAPPERS");
+            args.insert(args.end(), { "-c", src, "-o", obj });
+            Run(args);
+            auto size = ReadObjectSize(obj);
+            sizes[m].code += size.code;
+            sizes[m].data += size.data;
+            sizes[m].wrappers += size.wrappers;
+        }
+    }
+
+    const size_t wraps = max<size_t>(1, sizes[0].wrappers);
+    cout << sizes[0].wrappers << " wraps in " << wrap_sources.size()
+            << " files\n" << left << setw(10) << "mode" << right << setw(12)
+            << "code" << setw(12) << "data" << setw(12) << "code/wrap"
+            << setw(12) << "data/wrap" << '\n';
+    for (int m = 0; m < 2; ++m)
+        cout << left << setw(10) << modes[m] << right << setw(12)
+                << sizes[m].code << setw(12) << sizes[m].data << setw(12)
+                << sizes[m].code / wraps << setw(12) << sizes[m].data / wraps
+                << '\n';
+    cout << fixed << setprecision(0) << "Code saving: "
+            << (sizes[0].code - sizes[1].code) * 100.0 / max<size_t>(1,
+                sizes[0].code) << '%' << endl;
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        if (argc == 7 && argv[1] == "generate"s)
+            Generate(argv[2], stoul(argv[3]), max(1ul, stoul(argv[4])),
+                stoul(argv[5]), max(1ul, stoul(argv[6])));
+        else if (argc == 7 && argv[1] == "run"s)
+            RunBenchmark(max(1ul, stoul(argv[2])), argv[3], argv[4], argv[5],
+                argv[6]);
+        else if (argc > 5 && argv[1] == "link"s)
+            RunLinkBenchmark(max(1ul, stoul(argv[2])), argv[3], argv[4],
+                vector<string>(argv + 5, argv + argc));
+        else if (argc > 11 && argv[1] == "scale"s)
+        {
+            auto sep = find(argv + 9, argv + argc, "--"s);
+            if (sep == argv + 9 || sep == argv + argc)
+                throw runtime_error("scale: compile command and wrapper "
+                        "sources should be separated by --");
+            RunScaleBenchmark(max(1ul, stoul(argv[2])), argv[3], argv[4],
+                argv[5], argv[6], argv[7], argv[8],
+                vector<string>(argv + 9, sep),
+                vector<string>(sep + 1, argv + argc));
+        }
+        else if (argc > 4 && argv[1] == "size"s)
+        {
+            auto sep = find(argv + 3, argv + argc, "--"s);
+            if (sep == argv + 3 || sep == argv + argc)
+                throw runtime_error("size: compile command and wrapper "
+                        "sources should be separated by --");
+            RunSizeBenchmark(argv[2], vector<string>(argv + 3, sep),
+                vector<string>(sep + 1, argv + argc));
+        }
+        else
+        {
+            cerr << "Usage:\n  " << argv[0] << " generate <out_dir> <symbols>"
+                    " <lib_files> <wraps> <wrap_files>\n  " << argv[0]
+                    << " run <repeat> <work_dir> <bind_fakes_helper>"
+                    " <base_lib> <wrapper_lib>\n  " << argv[0]
+                    << " link <repeat> <output> <linkers> <link_command>...\n  "
+                    << argv[0] << " scale <repeat> <work_dir> <bind_fakes>"
+                    " <base_lib> <wrapper_lib> <powerfake_lib> <main_obj>"
+                    " <compile_command>... -- <wrap_sources>...\n  " << argv[0]
+                    << " size <work_dir> <compile_command>... --"
+                    " <wrap_sources>..." << endl;
+            return 1;
+        }
+    }
+    catch (exception &e)
+    {
+        cerr << "Exception: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
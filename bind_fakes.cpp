@@ -14,11 +14,27 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <atomic>
 #include <boost/core/demangle.hpp>
 
 #include "powerfake.h"
 #include "NMSymbolReader.h"
 #include "SymbolAliasMap.h"
+#include "SymbolRenamer.h"
+#include "ArchiveFile.h"
+#include "BindCache.h"
+#include "BindStats.h"
+#include "CallSiteAnalysis.h"
+#include "ElfFile.h"
+#include "FileUtils.h"
+#include "PrototypeManifest.h"
+#include "PrototypeNotes.h"
+#include "SymbolIndex.h"
+#include "SymbolPipeline.h"
+#include "WrapperShards.h"
 
 #define TO_STR(a) #a
 #define BUILD_NAME_STR(pref, base, post) TO_STR(pref) + base + TO_STR(post)
@@ -30,24 +46,57 @@ using namespace PowerFake;
 
 
 string NMCommand(string objfile);
-Reader *GetReader(bool passive, string file);
+Reader *GetReader(bool passive, string file, BindStats *stats);
+string RenameSymbols(const string &objfile, const ElfFile::RenameMap &renames,
+    bool external_objcopy, const string &output_dir, BindStats *stats);
+void RunObjcopy(const string &objfile, const ElfFile::RenameMap &renames,
+    const string &output_file = "");
+string ResponseFileArg(const string &arg);
+string ObjcopyParams(const ElfFile::RenameMap &renames);
+void FindSymbolsUsingIndex(SymbolAliasMap &symmap, const string &index_file,
+    const string &base_lib, BindStats *stats);
+void FindSymbols(SymbolAliasMap &symmap, const string &base_lib,
+    const string &index_file, bool passive, bool leading_underscore,
+    unsigned jobs, BindStats *stats);
+void ReadSymbolsTimed(SymbolAliasMap &symmap, NMSymbolReader &nm_reader,
+    BindStats &stats);
+void ReportStats(const BindStats &stats, bool print, const string &json_file);
+set<string> UnreferencedAliases(const SymbolAliasMap::MapType &symbols,
+    const vector<string> &base_libs, const vector<string> &ref_objects);
+bool LinkerSupported(const string &linker);
+void WriteOutputs(const string &link_flags, const string &link_flags_file,
+    const string &depfile, const string &stamp, const vector<string> &inputs);
 
 
 int main(int argc, char **argv)
 {
-    if (argc < 3)
-    {
-        cerr << "At least one base library name and one wrapping object/library"
-                " are required: " << argv[0] << " <base_lib.a> <wrapper.o/.a>..."
-                << endl;
-        return 1;
-    }
-
     try
     {
         bool passive_mode = false;
         bool leading_underscore = false;
         bool use_objcopy = true;
+        bool external_objcopy = false;
+        string cache_file;
+        vector<string> symbol_indexes;
+        string symbol_index_suffix;
+        vector<string> base_libs;
+        bool print_stats = false;
+        bool error_on_clones = false;
+        bool call_sites = false;
+        bool prune_unreferenced = false;
+        vector<string> ref_objects;
+        string stats_json;
+        string write_manifest;
+        string link_flags_file = "powerfake.link_flags";
+        string objcopy_params_prefix;
+        string output_dir;
+        string depfile;
+        string stamp;
+        string linker;
+        vector<string> manifests;
+        // reading symbols is mostly I/O bound, so threads are only used if
+        // requested by --jobs
+        unsigned jobs = 1;
         int argc_inc = 0;
 
         for (int i = 1; i < argc; ++i)
@@ -72,103 +121,465 @@ int main(int argc, char **argv)
                 use_objcopy = false;
                 argc_inc++;
             }
+            else if (argv[i] == "--external-objcopy"s)
+            {
+                external_objcopy = true;
+                argc_inc++;
+            }
+            else if (argv[i] == "--cache"s && i + 1 < argc)
+            {
+                cache_file = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--jobs"s && i + 1 < argc)
+            {
+                jobs = stoul(argv[++i]);
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--symbol-index"s && i + 1 < argc)
+            {
+                // index file of the base library, then of each --base-lib
+                // library in order if given several times
+                symbol_indexes.push_back(argv[++i]);
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--symbol-index-suffix"s && i + 1 < argc)
+            {
+                symbol_index_suffix = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--base-lib"s && i + 1 < argc)
+            {
+                // searched after the base library given as the first
+                // positional argument
+                base_libs.push_back(argv[++i]);
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--error-on-clones"s)
+            {
+                error_on_clones = true;
+                argc_inc++;
+            }
+            else if (argv[i] == "--call-sites"s)
+            {
+                // report references of wrapped symbols in base libraries
+                call_sites = true;
+                argc_inc++;
+            }
+            else if (argv[i] == "--prune-unreferenced"s)
+            {
+                // do not wrap symbols which are not referenced from other
+                // objects of the base libraries and --ref-object files (which
+                // should contain all objects of the test binary)
+                prune_unreferenced = true;
+                argc_inc++;
+            }
+            else if (argv[i] == "--ref-object"s && i + 1 < argc)
+            {
+                // other objects/libraries referencing wrapped functions, e.g.
+                // test objects, for --prune-unreferenced
+                ref_objects.push_back(argv[++i]);
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--stats"s)
+            {
+                print_stats = true;
+                argc_inc++;
+            }
+            else if (argv[i] == "--stats-json"s && i + 1 < argc)
+            {
+                stats_json = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--manifest"s && i + 1 < argc)
+            {
+                // prototypes of a wrapper library, when this binary is not
+                // linked with it
+                manifests.push_back(argv[++i]);
+                for (auto &proto: PrototypeManifest::Read(manifests.back()))
+                    WrapperBase::AddPrototype(move(proto));
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--link-flags"s && i + 1 < argc)
+            {
+                link_flags_file = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--objcopy-params-prefix"s && i + 1 < argc)
+            {
+                // passive mode objcopy params are written into
+                // <prefix><objname>.objcopy_params rather than beside objects
+                objcopy_params_prefix = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--output-dir"s && i + 1 < argc)
+            {
+                // write renamed copies of wrapper objects into this directory
+                // rather than modifying them in place
+                output_dir = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--linker"s && i + 1 < argc)
+            {
+                // linker used for the test binary, see LinkerSupported()
+                linker = argv[++i];
+                if (!LinkerSupported(linker))
+                    throw runtime_error("Unsupported linker: " + linker
+                        + " (supported: bfd, gold)");
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--depfile"s && i + 1 < argc)
+            {
+                depfile = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--stamp"s && i + 1 < argc)
+            {
+                stamp = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--write-manifest"s && i + 1 < argc)
+            {
+                write_manifest = argv[++i];
+                argc_inc += 2;
+            }
+            else if (argv[i] == "--write-shards"s && i + 3 < argc)
+            {
+                // only generate wrapper sources from a list of wrapped
+                // functions: --write-shards <list> <count> <output_prefix>
+                size_t written = WrapperShards::Write(argv[i + 1],
+                    stoul(argv[i + 2]), argv[i + 3]);
+                cout << "Wrapper sources updated: " << written << endl;
+                return 0;
+            }
             else
                 break;
         }
 
+        // If this binary is not linked with the wrapper library and no
+        // manifest is given, read prototypes recorded in wrapper objects. With
+        // --write-manifest, all remaining arguments are wrapper objects.
+        if (WrapperBase::WrappedFunctions().empty() && !passive_mode)
+        {
+            const int first_wrapper = argc_inc + (write_manifest.empty() ? 2 : 1);
+            for (int i = first_wrapper; i < argc; ++i)
+                for (auto &proto: PrototypeNotes::Read(argv[i]))
+                    WrapperBase::AddPrototype(move(proto));
+        }
+
+        if (!write_manifest.empty())
+        {
+            PrototypeManifest::Write(write_manifest,
+                WrapperBase::WrappedFunctions());
+            return 0;
+        }
+
+        if (argc - argc_inc < 3)
+        {
+            cerr << "At least one base library name and one wrapping "
+                    "object/library are required: " << argv[0]
+                    << " [options] <base_lib.a> <wrapper.o/.a>..." << endl;
+            return 1;
+        }
+
+        // calls from the test binary are wrapped too, so pruning without its
+        // objects would prune wrappers which are actually used
+        if (prune_unreferenced && ref_objects.empty())
+            throw runtime_error("--prune-unreferenced needs the objects of the "
+                    "test binary, given with --ref-object");
+
+        base_libs.insert(base_libs.begin(), argv[argc_inc + 1]);
         vector<string> object_files;
         for (int i = argc_inc + 2; i < argc; ++i)
             object_files.push_back(argv[i]);
+        // real inputs of this run, for the depfile
+        vector<string> inputs(base_libs);
+        inputs.insert(inputs.end(), object_files.begin(), object_files.end());
+        inputs.insert(inputs.end(), manifests.begin(), manifests.end());
+        inputs.insert(inputs.end(), ref_objects.begin(), ref_objects.end());
+
+        // stats are only collected if requested, as timing each symbol has
+        // a noticeable cost
+        unique_ptr<BindStats> stats_ptr;
+        if (print_stats || !stats_json.empty())
+            stats_ptr.reset(new BindStats);
+        BindStats *stats = stats_ptr.get();
+        BindStats::Timer total_timer;
+        total_timer.Start();
+
+        // If the base library, wrapper objects and wrapped prototypes are the
+        // same as the previous run, replay its results. Wrapper objects might
+        // be already processed by the previous run.
+        BindCache cache;
+        vector<uint64_t> object_hashes;
+        const bool use_cache = !cache_file.empty() && !passive_mode;
+        if (use_cache)
+        {
+            cache.key.options = "objcopy="s + (use_objcopy ? "1" : "0")
+                    + " external=" + (external_objcopy ? "1" : "0")
+                    + " underscore=" + (leading_underscore ? "1" : "0")
+                    + " output_dir=" + output_dir
+                    + " prune=" + (prune_unreferenced ? "1" : "0")
+                    + " linker=" + linker;
+            cache.key.base_hash = FileHash(base_libs[0]);
+            for (size_t i = 1; i < base_libs.size(); ++i)
+                cache.key.base_hash = ContentHash(
+                    to_string(FileHash(base_libs[i])), cache.key.base_hash);
+            if (prune_unreferenced)
+                for (const auto &ref_object: ref_objects)
+                    cache.key.base_hash = ContentHash(
+                        to_string(FileHash(ref_object)), cache.key.base_hash);
+            cache.key.prototypes_hash = BindCache::PrototypesHash(
+                WrapperBase::WrappedFunctions());
+            for (const auto &objfile: object_files)
+                object_hashes.push_back(FileHash(objfile));
+
+            BindCache prev;
+            if (prev.Load(cache_file)
+                    && prev.Matches(cache.key, object_files, object_hashes))
+            {
+                cout << "Replaying cached results: " << cache_file << endl;
+                {
+                    BindStats::ScopedPhase phase(stats, BindStats::LINK_FLAGS);
+                    WriteOutputs(prev.link_flags, link_flags_file, depfile,
+                        stamp, inputs);
+                }
+                {
+                    BindStats::ScopedPhase phase(stats, BindStats::RENAME,
+                        object_files.size());
+                    // renamed copies are recreated if removed or modified
+                    for (size_t i = 0; i < object_files.size(); ++i)
+                        if (object_hashes[i] != prev.objects[i].output_hash
+                                || (!output_dir.empty()
+                                    && !prev.objects[i].renames.empty()))
+                            RenameSymbols(object_files[i],
+                                prev.objects[i].renames, external_objcopy,
+                                output_dir, stats);
+                }
+                if (stats)
+                {
+                    stats->cached = true;
+                    stats->matched = prev.symbol_map.size();
+                    total_timer.Stop();
+                    stats->Add(BindStats::TOTAL, total_timer);
+                    ReportStats(*stats, print_stats, stats_json);
+                }
+                return 0;
+            }
+        }
+
+        // symbol index of each base library
+        vector<string> index_files(base_libs.size());
+        if (!passive_mode && !leading_underscore)
+        {
+            for (size_t i = 0; i < base_libs.size(); ++i)
+                if (!symbol_index_suffix.empty())
+                    index_files[i] = base_libs[i] + symbol_index_suffix;
+            for (size_t i = 0; i < min(symbol_indexes.size(),
+                    base_libs.size()); ++i)
+                index_files[i] = symbol_indexes[i];
+        }
 
         SymbolAliasMap symmap;
         // Found real symbols which we want to wrap
+        if (base_libs.size() == 1)
+            FindSymbols(symmap, base_libs[0], index_files[0], passive_mode,
+                leading_underscore, jobs, stats);
+        else
         {
-            unique_ptr<Reader> reader(GetReader(passive_mode,
-                argv[argc_inc + 1]));
-            NMSymbolReader nm_reader(reader.get(), leading_underscore);
-
-            const char *symbol;
-            while ((symbol = nm_reader.NextSymbol()))
-                symmap.AddSymbol(symbol);
+            // Scan base libraries concurrently, each into its own map. Maps
+            // are merged in the order of libraries, so if a function is found
+            // in several libraries, the first one wins.
+            vector<SymbolAliasMap> lib_maps(base_libs.size());
+            vector<ostringstream> logs(base_libs.size());
+            vector<exception_ptr> errors(base_libs.size());
+            atomic<size_t> next_lib(0);
+            const unsigned threads = min<size_t>(max(jobs, 1u),
+                base_libs.size());
+            vector<thread> scanners;
+            for (unsigned t = 0; t < threads; ++t)
+                scanners.emplace_back([&]() {
+                    for (size_t i; (i = next_lib++) < base_libs.size(); )
+                    {
+                        try
+                        {
+                            lib_maps[i].SetLog(logs[i]);
+                            FindSymbols(lib_maps[i], base_libs[i],
+                                index_files[i], passive_mode,
+                                leading_underscore, 1, stats);
+                        }
+                        catch (...)
+                        {
+                            errors[i] = current_exception();
+                        }
+                    }
+                });
+            for (auto &t: scanners)
+                t.join();
+            for (size_t i = 0; i < base_libs.size(); ++i)
+            {
+                if (errors[i])
+                    rethrow_exception(errors[i]);
+                cout << logs[i].str();
+                symmap.Merge(lib_maps[i], base_libs[i]);
+            }
         }
 
         if (!symmap.FoundAllWrappedSymbols())
             throw std::runtime_error("(BUG?) cannot find all wrapped "
                     "symbols in the given library file(s)");
+        // Clones of wrapped functions cannot be wrapped, see ReportClones()
+        if (symmap.ReportClones(cerr) && error_on_clones)
+            throw std::runtime_error("some wrapped functions have GCC clones");
+        if (call_sites)
+        {
+            CallSiteAnalysis analysis(symmap.Map());
+            for (const auto &lib: base_libs)
+                if (!analysis.AddFile(lib))
+                    cout << "Call sites are not analyzed in: " << lib << '\n';
+            analysis.Report(cout);
+        }
+        if (stats)
+            stats->matched = symmap.Map().size();
+
+        set<string> pruned;
+        if (prune_unreferenced)
+            pruned = UnreferencedAliases(symmap.Map(), base_libs,
+                ref_objects);
 
         // Create powerfake.link_flags containing link flags for linking
         // test binary
-        ofstream link_flags("powerfake.link_flags");
+        ostringstream link_flags;
+        if (!linker.empty())
+            link_flags << "-fuse-ld=" << linker << '\n';
         for (const auto &syms: symmap.Map())
-            link_flags << "-Wl,--wrap=" << syms.second << endl;
+            if (!pruned.count(syms.first))
+                link_flags << "-Wl,--wrap=" << syms.second << '\n';
 
         const string sym_prefix = leading_underscore ? "_" : "";
+        // gold does not apply --wrap to symbols used in --defsym expressions,
+        // so there __real_<symbol> is not defined and <symbol> itself is the
+        // real function. GNU ld would resolve <symbol> to the wrapper instead.
+        const bool defsym_wraps_real = linker != "gold";
+        // temporary wrapper and real symbol names for each alias
+        struct AliasSymbols
+        {
+            string wrapper_name;
+            string real_name;
+            const string &symbol;
+            /// not wrapped, so the wrapper calls the symbol itself
+            bool pruned;
+        };
+        vector<AliasSymbols> alias_symbols;
+        for (const auto &syms: symmap.Map())
+            alias_symbols.push_back(AliasSymbols {
+                TMP_WRAPPER_NAME_STR(syms.first), TMP_REAL_NAME_STR(syms.first),
+                syms.second, pruned.count(syms.first) > 0 });
+
         // Rename our wrap/real symbols (which are mangled) to the ones expected
         // by ld linker
-        for (const auto &objfile: object_files)
+        BindStats::Timer rename_timer;
+        rename_timer.Start();
+        for (size_t objidx = 0; objidx < object_files.size(); ++objidx)
         {
-            unique_ptr<Reader> reader(GetReader(passive_mode, objfile));
+            const auto &objfile = object_files[objidx];
+            unique_ptr<Reader> reader(GetReader(passive_mode, objfile, stats));
             NMSymbolReader nm_reader(reader.get(), leading_underscore);
 
-            string objcopy_params;
-            const char *symbol;
-            while ((symbol = nm_reader.NextSymbol()))
+            ElfFile::RenameMap renames;
+            size_t found_symbols = 0;
+            string_view symbol;
+            while (!(symbol = nm_reader.NextSymbol()).empty())
             {
                 if (symbol[0] == '.')
                     continue;
-                for (const auto &syms: symmap.Map())
+                for (const auto &syms: alias_symbols)
                 {
-                    string wrapper_name = TMP_WRAPPER_NAME_STR(syms.first);
-                    string real_name = TMP_REAL_NAME_STR(syms.first);
-                    string symbol_str = symbol;
-                    if (symbol_str.find(wrapper_name) != string::npos)
+                    if (!syms.pruned
+                            && symbol.find(syms.wrapper_name) != string::npos)
                     {
-                        cout << "Found wrapper symbol to rename: " << symbol_str
-                                << ' ' << boost::core::demangle(symbol) << endl;
+                        ++found_symbols;
+                        cout << "Found wrapper symbol to rename: " << symbol
+                                << ' ' << boost::core::demangle(symbol.data())
+                                << '\n';
                         if (!use_objcopy)
                             link_flags << "-Wl,--defsym=" << sym_prefix << "__wrap_"
-                                << syms.second << '=' << sym_prefix
-                                << symbol_str << endl;
+                                << syms.symbol << '=' << sym_prefix
+                                << symbol << '\n';
                         else
-                            objcopy_params += " --redefine-sym " + sym_prefix
-                                + symbol_str + "=" + sym_prefix + "__wrap_"
-                                + syms.second;
+                            renames[sym_prefix + string(symbol)] = sym_prefix
+                                + "__wrap_" + syms.symbol;
                     }
-                    if (symbol_str.find(real_name) != string::npos)
+                    if (symbol.find(syms.real_name) != string::npos)
                     {
-                        cout << "Found real symbol to rename: " << symbol_str
-                                << ' ' << boost::core::demangle(symbol) << endl;
+                        ++found_symbols;
+                        cout << "Found real symbol to rename: " << symbol
+                                << ' ' << boost::core::demangle(symbol.data())
+                                << '\n';
+                        const string real_prefix = syms.pruned ? "" : "__real_";
                         if (!use_objcopy)
                             link_flags << "-Wl,--defsym=" << sym_prefix
-                                << symbol_str << '=' << sym_prefix << "__real_"
-                                << syms.second << endl;
+                                << symbol << '=' << sym_prefix
+                                << (defsym_wraps_real ? real_prefix : "")
+                                << syms.symbol << '\n';
                         else
-                            objcopy_params += " --redefine-sym " + sym_prefix
-                                + symbol_str + "=" + sym_prefix + "__real_"
-                                + syms.second;
+                            renames[sym_prefix + string(symbol)] = sym_prefix
+                                + real_prefix + syms.symbol;
                     }
                 }
             }
+            if (stats)
+            {
+                stats->wrapper_symbols += found_symbols;
+                ++stats->wrapper_objects;
+            }
             if (use_objcopy)
             {
                 if (passive_mode)
                 {
                     // Create <objname>.objcopy_params containing objcopy
                     // params to modify symbol names
-                    ofstream objcopy_params_file(objfile + ".objcopy_params");
-                    objcopy_params_file << objcopy_params << endl;
-                }
-                else if (!objcopy_params.empty())
-                {
-                    string cmd = "objcopy" + objcopy_params + ' ' + objfile;
-                    int ret = system(cmd.c_str());
-    #ifdef _XOPEN_SOURCE
-                    if (!WIFEXITED(ret) || WEXITSTATUS(ret) != 0)
-                        throw runtime_error("Running objcopy failed");
-    #endif
+                    const string params_file = objcopy_params_prefix.empty()
+                            ? objfile : objcopy_params_prefix
+                                + objfile.substr(objfile.rfind('/') + 1);
+                    WriteFileIfChanged(params_file + ".objcopy_params",
+                        ObjcopyParams(renames) + '\n');
                 }
+                else if (!renames.empty())
+                    link_flags << RenameSymbols(objfile, renames,
+                        external_objcopy, output_dir, stats);
+            }
+            if (use_cache)
+            {
+                const uint64_t output_hash = renames.empty()
+                        || !output_dir.empty() ? object_hashes[objidx]
+                        : FileHash(objfile);
+                cache.objects.push_back(BindCache::ObjectEntry { objfile,
+                    object_hashes[objidx], output_hash, move(renames) });
             }
         }
+
+        rename_timer.Stop();
+        if (stats)
+            stats->Add(BindStats::RENAME, rename_timer, object_files.size());
+
+        {
+            BindStats::ScopedPhase phase(stats, BindStats::LINK_FLAGS);
+            WriteOutputs(link_flags.str(), link_flags_file, depfile, stamp,
+                inputs);
+        }
+        if (use_cache)
+        {
+            cache.symbol_map = symmap.Map();
+            cache.link_flags = link_flags.str();
+            cache.Save(cache_file);
+        }
+        if (stats)
+        {
+            total_timer.Stop();
+            stats->Add(BindStats::TOTAL, total_timer);
+            ReportStats(*stats, print_stats, stats_json);
+        }
     }
     catch (exception &e)
     {
@@ -181,11 +592,299 @@ int main(int argc, char **argv)
 
 string NMCommand(string objfile)
 {
+    // only exported symbols of shared objects can be wrapped
+    if (ElfFile::IsSharedObject(ReadFileHead(objfile, 64)))
+        return "nm -poD --defined-only " + objfile;
     return "nm -po " + objfile;
 }
 
-Reader *GetReader(bool passive, string file)
+Reader *GetReader(bool passive, string file, BindStats *stats)
 {
     if (passive) return new FileReader(file);
+    if (stats)
+        ++stats->processes;
     return new PipeReader(NMCommand(file));
 }
+
+string ObjcopyParams(const ElfFile::RenameMap &renames)
+{
+    string params;
+    for (const auto &r: renames)
+        params += " --redefine-sym " + r.first + "=" + r.second;
+    return params;
+}
+
+/**
+ * Renames symbols of @p objfile in place, or writes renamed copies of it into
+ * @p output_dir if given.
+ * @return link flags to link renamed copies instead of @p objfile
+ */
+string RenameSymbols(const string &objfile, const ElfFile::RenameMap &renames,
+    bool external_objcopy, const string &output_dir, BindStats *stats)
+{
+    // rename symbols in-process if possible, which avoids spawning a process
+    // for each file
+    string link_flags;
+    if (!external_objcopy && SymbolRenamer::IsSupported(objfile))
+    {
+        if (output_dir.empty())
+            SymbolRenamer(renames).RenameFile(objfile);
+        else
+            for (const auto &copy: SymbolRenamer(renames).CopyRenamed(objfile,
+                    output_dir))
+                link_flags += ResponseFileArg(copy) + '\n';
+        return link_flags;
+    }
+
+    if (stats)
+        ++stats->processes;
+    if (output_dir.empty())
+    {
+        RunObjcopy(objfile, renames);
+        return link_flags;
+    }
+
+    // members of a renamed archive would not be pulled in by the linker, as
+    // link flags come before other objects
+    const string copy = output_dir + '/' + objfile.substr(objfile.rfind('/')
+        + 1);
+    CreateDirectories(output_dir);
+    RunObjcopy(objfile, renames, copy);
+    if (ArchiveFile::IsArchive(ReadFileHead(copy, 8)))
+        return "-Wl,--whole-archive\n" + ResponseFileArg(copy)
+            + "\n-Wl,--no-whole-archive\n";
+    return ResponseFileArg(copy) + '\n';
+}
+
+void RunObjcopy(const string &objfile, const ElfFile::RenameMap &renames,
+    const string &output_file)
+{
+    string cmd = "objcopy" + ObjcopyParams(renames) + ' ' + objfile;
+    if (!output_file.empty())
+        cmd += ' ' + output_file;
+    int ret = system(cmd.c_str());
+#ifdef _XOPEN_SOURCE
+    if (!WIFEXITED(ret) || WEXITSTATUS(ret) != 0)
+        throw runtime_error("Running objcopy failed");
+#endif
+}
+
+/**
+ * @return @p arg escaped to be used in a GCC response file
+ */
+string ResponseFileArg(const string &arg)
+{
+    string escaped;
+    for (char c: arg)
+    {
+        if (isspace(static_cast<unsigned char>(c)) || c == '\\' || c == '\''
+                || c == '"')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+/**
+ * Finds wrapped symbols of @p base_lib, using its symbol index if
+ * @p index_file is given, or by reading symbols using nm
+ */
+void FindSymbols(SymbolAliasMap &symmap, const string &base_lib,
+    const string &index_file, bool passive, bool leading_underscore,
+    unsigned jobs, BindStats *stats)
+{
+    if (!index_file.empty())
+    {
+        FindSymbolsUsingIndex(symmap, index_file, base_lib, stats);
+        return;
+    }
+
+    unique_ptr<Reader> reader(GetReader(passive, base_lib, stats));
+    NMSymbolReader nm_reader(reader.get(), leading_underscore);
+
+    // overlap reading and demangling if possible
+    if (jobs > 1)
+        SymbolPipeline(symmap, jobs, 1024, stats).Run(nm_reader);
+    else if (stats)
+        ReadSymbolsTimed(symmap, nm_reader, *stats);
+    else
+    {
+        string_view symbol;
+        while (!(symbol = nm_reader.NextSymbol()).empty())
+            symmap.AddSymbol(symbol.data());
+    }
+}
+
+/**
+ * Finds wrapped symbols using the symbol index of the base library, updating
+ * the index first if the library is changed
+ */
+void FindSymbolsUsingIndex(SymbolAliasMap &symmap, const string &index_file,
+    const string &base_lib, BindStats *stats)
+{
+    // updating the index reads and demangles symbols of changed members, it
+    // is accounted as the read phase
+    BindStats::ScopedPhase read_phase(stats, BindStats::READ);
+    auto update = SymbolIndex::Update(index_file, base_lib);
+    // logged by symmap, as base libraries might be scanned concurrently
+    symmap.Log() << "Symbol index " << index_file << ": "
+            << update.reused_members << " members reused, "
+            << update.scanned_members << " scanned" << endl;
+
+    SymbolIndex index;
+    if (!index.Open(index_file))
+        throw runtime_error("Cannot open symbol index: " + index_file);
+
+    BindStats::ScopedPhase match_phase(stats, BindStats::MATCH);
+    if (stats)
+        stats->symbols += index.Size();
+    const auto &protos = WrapperBase::WrappedFunctions();
+    for (auto p = protos.begin(); p != protos.end();
+            p = protos.upper_bound(p->first))
+    {
+        auto range = index.Find(p->first);
+        for (auto i = range.first; i < range.second; ++i)
+        {
+            auto entry = index.At(i);
+            symmap.AddSymbol(entry.mangled.data(), string(entry.demangled));
+            if (stats)
+                ++stats->candidates;
+        }
+    }
+}
+
+/**
+ * Same as feeding all symbols of @p nm_reader to SymbolAliasMap::AddSymbol(),
+ * but measures the time spent in each phase separately
+ */
+void ReadSymbolsTimed(SymbolAliasMap &symmap, NMSymbolReader &nm_reader,
+    BindStats &stats)
+{
+    BindStats::Timer read, demangle, match;
+    uint64_t symbols = 0, candidates = 0;
+    string_view symbol;
+    while (true)
+    {
+        read.Start();
+        symbol = nm_reader.NextSymbol();
+        read.Stop();
+        if (symbol.empty())
+            break;
+        ++symbols;
+
+        demangle.Start();
+        const bool candidate = symmap.IsCandidate(symbol.data());
+        string demangled;
+        if (candidate)
+            demangled = boost::core::demangle(symbol.data());
+        demangle.Stop();
+        if (!candidate)
+            continue;
+        ++candidates;
+
+        match.Start();
+        symmap.AddSymbol(symbol.data(), demangled);
+        match.Stop();
+    }
+    stats.Add(BindStats::READ, read, symbols);
+    stats.Add(BindStats::DEMANGLE, demangle, symbols);
+    stats.Add(BindStats::MATCH, match, candidates);
+    stats.symbols += symbols;
+    stats.candidates += candidates;
+}
+
+void ReportStats(const BindStats &stats, bool print, const string &json_file)
+{
+    if (print)
+        stats.Report(cout);
+    if (!json_file.empty())
+    {
+        ofstream json(json_file);
+        stats.WriteJson(json);
+        if (!json)
+            throw runtime_error("Cannot write stats file: " + json_file);
+    }
+}
+
+/**
+ * Writes @p link_flags_file only if changed, so that the test binary is not
+ * relinked needlessly. If requested, writes a Make/Ninja depfile listing
+ * @p inputs and touches the @p stamp file, which is the target of the depfile
+ * if given.
+ */
+void WriteOutputs(const string &link_flags, const string &link_flags_file,
+    const string &depfile, const string &stamp, const vector<string> &inputs)
+{
+    WriteFileIfChanged(link_flags_file, link_flags);
+
+    if (!depfile.empty())
+    {
+        auto escape = [](const string &path) {
+            string escaped;
+            for (char c: path)
+            {
+                if (c == ' ' || c == '#')
+                    escaped += '\\';
+                else if (c == '$')
+                    escaped += '$';
+                escaped += c;
+            }
+            return escaped;
+        };
+        string deps = escape(stamp.empty() ? link_flags_file : stamp) + ':';
+        for (const auto &input: inputs)
+            deps += " \\\n " + escape(input);
+        deps += '\n';
+        WriteFileIfChanged(depfile, deps);
+    }
+
+    // the stamp is always updated, so that build tools know this run is done
+    if (!stamp.empty())
+        WriteFileAtomically(stamp, "");
+}
+
+/**
+ * Finds wrapped symbols which are not referenced from objects other than the
+ * ones defining them, in @p base_libs and @p ref_objects. --wrap has no effect
+ * on such symbols, so they are not wrapped. Nothing is pruned if a file cannot
+ * be analyzed (e.g. shared objects).
+ * @return aliases of unreferenced symbols
+ */
+set<string> UnreferencedAliases(const SymbolAliasMap::MapType &symbols,
+    const vector<string> &base_libs, const vector<string> &ref_objects)
+{
+    CallSiteAnalysis analysis(symbols);
+    vector<string> files(base_libs);
+    files.insert(files.end(), ref_objects.begin(), ref_objects.end());
+    for (const auto &file: files)
+        if (!analysis.AddFile(file))
+        {
+            cerr << "Warning: not pruning unreferenced wrappers, cannot "
+                    "analyze references in: " << file << endl;
+            return {};
+        }
+
+    const auto unreferenced = analysis.Unreferenced();
+    set<string> pruned;
+    for (const auto &syms: symbols)
+    {
+        if (!unreferenced.count(syms.second))
+            continue;
+        pruned.insert(syms.first);
+        cerr << "Warning: not wrapping " << boost::core::demangle(
+            syms.second.c_str()) << ", it is not referenced from other "
+            "objects of base libraries or --ref-object files" << endl;
+    }
+    return pruned;
+}
+
+/**
+ * @return true if @p linker can be passed to --linker, i.e. to -fuse-ld. Only
+ * linkers verified by test_linkers target of the samples are supported. lld is
+ * not: its --wrap also redirects references from the object defining a
+ * symbol (e.g. from vtables), so it fakes calls which GNU ld does not.
+ */
+bool LinkerSupported(const string &linker)
+{
+    return linker == "bfd" || linker == "gold";
+}
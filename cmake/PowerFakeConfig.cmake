@@ -1,5 +1,6 @@
 include(CMakeFindDependencyMacro)
 find_dependency(Boost)
+find_dependency(Threads)
 
 include("${CMAKE_CURRENT_LIST_DIR}/PowerFakeTargets.cmake")
 include("${CMAKE_CURRENT_LIST_DIR}/PowerFakeFunctions.cmake")
@@ -1,24 +1,145 @@
+# Creates static library target_name with wrappers of functions listed in
+# list_file (see WrapperShards.h), split into several sources which can be
+# compiled in parallel. The number of sources is given as the optional third
+# argument, or POWERFAKE_WRAPPER_SHARDS, or the number of processors.
+function(add_wrapper_library target_name list_file)
+    if(ARGC GREATER 2)
+        set(shards ${ARGV2})
+    elseif(POWERFAKE_WRAPPER_SHARDS)
+        set(shards ${POWERFAKE_WRAPPER_SHARDS})
+    else()
+        cmake_host_system_information(RESULT shards
+            QUERY NUMBER_OF_LOGICAL_CORES)
+    endif()
+    get_filename_component(list_file ${list_file} ABSOLUTE)
+
+    # sources are rewritten only if changed, so that only the changed ones are
+    # recompiled
+    set(prefix ${CMAKE_CURRENT_BINARY_DIR}/${target_name}_)
+    set(sources)
+    math(EXPR last "${shards} - 1")
+    foreach(i RANGE ${last})
+        list(APPEND sources ${prefix}${i}.cpp)
+    endforeach()
+    add_custom_command(OUTPUT ${prefix}stamp
+        BYPRODUCTS ${sources}
+        COMMAND $<TARGET_FILE:PowerFake::bind_fakes>
+                --write-shards ${list_file} ${shards} ${prefix}
+        COMMAND ${CMAKE_COMMAND} -E touch ${prefix}stamp
+        DEPENDS ${list_file} PowerFake::bind_fakes
+        COMMENT "Generating wrapper sources of ${target_name}")
+    add_library(${target_name} STATIC ${prefix}stamp ${sources})
+    target_link_libraries(${target_name} PowerFake::powerfake)
+endfunction(add_wrapper_library)
+
+# Binds fakes of wrapper_funcs_lib to target_name, which is tested against
+# test_lib. wrapper_funcs_lib can also be a list of wrapped functions with
+# .wraps extension, which is compiled into ${target_name}_wrappers library
+# using add_wrapper_library(); it can use usage requirements of test_lib.
 function(bind_fakes target_name test_lib wrapper_funcs_lib)
+    if(NOT TARGET ${wrapper_funcs_lib} AND wrapper_funcs_lib MATCHES "\\.wraps$")
+        add_wrapper_library(${target_name}_wrappers ${wrapper_funcs_lib})
+        target_link_libraries(${target_name}_wrappers ${test_lib})
+        target_link_libraries(${target_name} ${target_name}_wrappers)
+        set(wrapper_funcs_lib ${target_name}_wrappers)
+    endif()
     target_link_libraries(${wrapper_funcs_lib} PowerFake::powerfake)
+    # POWERFAKE_COMPACT_WRAPPERS reduces the code generated for each wrapped
+    # function (see powerfake.h)
+    if(POWERFAKE_COMPACT_WRAPPERS)
+        target_compile_definitions(${wrapper_funcs_lib} PRIVATE
+            POWERFAKE_COMPACT_WRAPPERS)
+    endif()
+
+    # test_lib can be a list of static and/or shared libraries; if a function
+    # is defined in more than one of them, the first one is used
+    list(GET test_lib 0 first_lib)
+    set(other_libs ${test_lib})
+    list(REMOVE_AT other_libs 0)
+    set(base_lib_args)
+    foreach(lib ${other_libs})
+        list(APPEND base_lib_args --base-lib $<TARGET_FILE:${lib}>)
+    endforeach()
+
+    # With POWERFAKE_SYMBOL_INDEX, symbols of each base library are kept in a
+    # per-target index file (see SymbolIndex.h), so that symbols of unchanged
+    # libraries and library members are not read and demangled again.
+    set(index_args)
+    set(index_files)
+    if(POWERFAKE_SYMBOL_INDEX)
+        foreach(lib ${test_lib})
+            string(MAKE_C_IDENTIFIER ${lib} lib_id)
+            set(index_file
+                ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.${lib_id}.powerfake_index)
+            list(APPEND index_args --symbol-index ${index_file})
+            list(APPEND index_files ${index_file})
+        endforeach()
+    endif()
 
-    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/dummy.cpp "")
-    set(bind_fakes_tgt bind_fakes_${target_name})
-    add_executable(${bind_fakes_tgt} EXCLUDE_FROM_ALL
-        ${CMAKE_CURRENT_BINARY_DIR}/dummy.cpp)
-    # Remove __real_ & __wrap_ functions to prevent undefined reference errors
-    # These are not used by bind_fakes
-    set_property(TARGET ${bind_fakes_tgt} APPEND PROPERTY
-        LINK_FLAGS "-Wl,--gc-sections")
-    target_link_libraries(${bind_fakes_tgt} PowerFake::pw_bindfakes
-        -Wl,--whole-archive ${wrapper_funcs_lib} -Wl,--no-whole-archive
-        $<TARGET_PROPERTY:${target_name},LINK_LIBRARIES>)
+    # Prototypes of wrapped functions are read from the notes recorded in
+    # wrapper objects by the generic bind_fakes binary. It only runs when one
+    # of its inputs is changed, and link flags are rewritten only if changed,
+    # so that no-op builds do not relink the test binary. The wrapper library
+    # is not modified: renamed copies of its objects are written into a
+    # per-target directory and linked through the link flags.
+    # All outputs are named after the target, so that several test targets
+    # can be bound in the same directory in parallel
+    set(stamp ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.powerfake_stamp)
+    set(link_flags ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.powerfake_link_flags)
+    set(depfile_args)
+    # POWERFAKE_LINKER (bfd or gold) selects the linker of test
+    # binaries, as --wrap/--defsym semantics are slightly different among them
+    set(linker_args)
+    if(POWERFAKE_LINKER)
+        set(linker_args --linker ${POWERFAKE_LINKER})
+    endif()
+    set(bind_args
+        --cache ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.powerfake_cache
+        ${index_args}
+        --link-flags ${link_flags}
+        --output-dir ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.powerfake_objects
+        --objcopy-params-prefix ${CMAKE_CURRENT_BINARY_DIR}/${target_name}.
+        ${linker_args})
+    # extra arguments are passed to bind_fakes before the input libraries
+    set(input_args ${base_lib_args} ${ARGN}
+        $<TARGET_FILE:${first_lib}> $<TARGET_FILE:${wrapper_funcs_lib}>)
 
-    add_custom_command(TARGET ${target_name} PRE_LINK
-        COMMAND ${bind_fakes_tgt} ${ARGV3}
-                $<TARGET_FILE:${test_lib}> $<TARGET_FILE:${wrapper_funcs_lib}>)
+    if(POWERFAKE_PRUNE_UNREFERENCED)
+        # Functions which are not referenced from base libraries or objects of
+        # target_name are not wrapped (see bind_fakes --prune-unreferenced);
+        # other libraries of target_name calling wrapped functions should be
+        # given as "--ref-object <file>" extra arguments. Target objects are
+        # built after the targets it depends on, so fakes are bound right
+        # before linking target_name.
+        add_custom_command(TARGET ${target_name} PRE_LINK
+            COMMAND $<TARGET_FILE:PowerFake::bind_fakes> ${bind_args}
+                    --prune-unreferenced
+                    --ref-object "$<JOIN:$<TARGET_OBJECTS:${target_name}>,;--ref-object;>"
+                    ${input_args}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+            BYPRODUCTS ${link_flags} ${index_files}
+            COMMENT "Binding fakes of ${target_name}"
+            COMMAND_EXPAND_LISTS)
+    else()
+        if(CMAKE_GENERATOR MATCHES "Ninja" OR NOT CMAKE_VERSION VERSION_LESS 3.20)
+            set(depfile_args DEPFILE ${stamp}.d)
+        endif()
+        add_custom_command(OUTPUT ${stamp}
+            BYPRODUCTS ${link_flags} ${index_files}
+            COMMAND $<TARGET_FILE:PowerFake::bind_fakes> ${bind_args}
+                    --depfile ${stamp}.d --stamp ${stamp} ${input_args}
+            DEPENDS ${test_lib} ${wrapper_funcs_lib} PowerFake::bind_fakes
+            ${depfile_args}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+            COMMENT "Binding fakes of ${target_name}")
+        add_custom_target(${target_name}_powerfake DEPENDS ${stamp})
+        add_dependencies(${target_name} ${target_name}_powerfake)
+        set_property(TARGET ${target_name} APPEND PROPERTY
+            LINK_DEPENDS ${link_flags})
+    endif()
 
     # Add powerfake link flags
     set_property(TARGET ${target_name} APPEND_STRING PROPERTY
-        LINK_FLAGS @${CMAKE_CURRENT_BINARY_DIR}/powerfake.link_flags)
+        LINK_FLAGS @${link_flags})
     target_link_libraries(${target_name} PowerFake::powerfake)
 endfunction(bind_fakes)
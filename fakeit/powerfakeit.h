@@ -13,6 +13,7 @@
 #ifndef FAKEIT_POWERFAKEIT_H_
 #define FAKEIT_POWERFAKEIT_H_
 
+#include <map>
 #include <powerfake.h>
 #include <fakeit.hpp>
 
@@ -14,6 +14,8 @@
 #include "powerfake.h"
 
 #include <iostream>
+#include <map>
+#include <stdexcept>
 #include <vector>
 
 /*
@@ -56,6 +58,11 @@ std::string ToStr(uint32_t q, bool mangled)
     return res;
 }
 
+class WrapperBase::FunctionWrappers:
+    public std::map<FunctionKey, WrapperBase *>
+{
+};
+
 // using pointers, as we can't rely on the order of construction of static
 // objects
 WrapperBase::Prototypes *WrapperBase::wrapped_funcs = nullptr;
@@ -68,14 +75,12 @@ const WrapperBase::Prototypes &WrapperBase::WrappedFunctions()
     return *wrapped_funcs;
 }
 
-void WrapperBase::AddFunction(FunctionKey func_key,
-    FunctionPrototype prototype [[maybe_unused]])
+void WrapperBase::AddPrototype(FunctionPrototype prototype)
 {
-#ifdef BIND_FAKES
     if (!wrapped_funcs)
         wrapped_funcs = new Prototypes();
     std::cout << "Add function prototype(" << prototype.alias << "): "
-            << prototype.Str() << std::endl;
+            << prototype.Str() << '\n';
     auto nstart = prototype.name.rfind(':', prototype.name.length()-1);
     std::string name;
     if (nstart != std::string::npos)
@@ -83,6 +88,32 @@ void WrapperBase::AddFunction(FunctionKey func_key,
     else
         name = prototype.name;
     wrapped_funcs->insert(std::make_pair(name, prototype));
+}
+
+WrapperBase *WrapperBase::FindWrapper(FunctionKey key)
+{
+    if (wrappers)
+    {
+        auto w = wrappers->find(key);
+        if (w != wrappers->end())
+            return w->second;
+    }
+    throw std::invalid_argument("Wrapped function with the given key not "
+            "found");
+}
+
+WrapperBase::WrapperBase(FunctionKey key)
+{
+    if (!wrappers)
+        wrappers = new FunctionWrappers;
+    (*wrappers)[key] = this;
+}
+
+void WrapperBase::AddFunction(FunctionKey func_key,
+    FunctionPrototype prototype [[maybe_unused]])
+{
+#ifdef BIND_FAKES
+    AddPrototype(prototype);
 #endif
 //    std::cout << this << ": Add function(" << prototype.alias << ")["
 //            << func_key.first << ", "
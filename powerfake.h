@@ -13,14 +13,15 @@
 #ifndef POWERFAKE_H_
 #define POWERFAKE_H_
 
-#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
-#include <vector>
-#include <functional>
 #include <stdexcept>
+#include <string>
 #include <typeindex>
-#include <type_traits>
+#include <utility>
 #include <boost/core/demangle.hpp>
 
 namespace PowerFake
@@ -64,25 +65,6 @@ static FakePtr MakeFake(Signature Class::*func_ptr, Functor f);
 template <typename PrivateMemberTag, typename Functor>
 static FakePtr MakeFake(Functor f);
 
-/**
- * Define a wrapper for the given function. For normal functions, it should be
- * called with the function name, e.g.:
- *      WRAP_FUNCTION(MyNameSpace::MyClass::MyFunction);
- * For overloaded function, you need to specify the function signature so
- * that the target function can be selected among the overloaded ones:
- *      WRAP_FUNCTION(void (MyNameSpace::MyClass::*)(int, float),
- *          MyNameSpace::MyClass::MyFunction)
- */
-#define WRAP_FUNCTION(...) \
-    SELECT_3RD(__VA_ARGS__, WRAP_FUNCTION_2, WRAP_FUNCTION_1)(__VA_ARGS__)
-
-#define WRAP_STATIC_MEMBER(...) \
-    SELECT_4TH(__VA_ARGS__, WRAP_STATIC_MEMBER_2, WRAP_STATIC_MEMBER_1)(__VA_ARGS__)
-
-#define WRAP_PRIVATE_MEMBER(...) \
-    SELECT_3RD(__VA_ARGS__, WRAP_PRIVATE_MEMBER_2, WRAP_PRIVATE_MEMBER_1)(__VA_ARGS__)
-
-
 /**
  * It is not possible to pass private member functions directly to MakeFake(),
  * Therefore, we need to create a tag for that member function and pass it to
@@ -234,8 +216,6 @@ Signature *FuncType(Signature *);
 template <typename FuncPtr>
 FuncPtr FuncType(FuncPtr);
 
-std::string ToStr(uint32_t q, bool mangled = false);
-
 // Provide access to private member functions. Inspired by:
 // http://bloglitb.blogspot.com/2011/12/access-to-private-members-safer.html
 template<typename Tag, auto PrivMemfuncPtr>
@@ -341,83 +321,53 @@ class Fake<R (T::*)(Args...)>: public FakeBase
 };
 
 
+struct FunctionPrototype;
+
 /**
- * Stores components of a function prototype and the function alias
+ * Type of fake function objects for function type T
  */
-struct FunctionPrototype
-{
-    FunctionPrototype(std::string ret, std::string name, std::string params,
-        uint32_t qual, std::string alias = "") :
-            return_type(ret), name(name), params(params), qual(qual),
-            alias(alias)
-    {
-    }
+template <typename T> struct FakeFunctionType;
 
-    std::string Str() const
-    {
-        return return_type + ' ' + name + params + ' ' + internal::ToStr(qual);
-    }
+template <typename T, typename R , typename ...Args>
+struct FakeFunctionType<R (T::*)(Args...)>
+{
+    typedef std::function<R (T *o, Args... args)> type;
+};
 
-    std::string return_type;
-    std::string name;
-    std::string params;
-    uint32_t qual;
-    std::string alias;
+template <typename R , typename ...Args>
+struct FakeFunctionType<R (*)(Args...)>
+{
+    typedef std::function<R (Args... args)> type;
 };
 
 /**
- * This class provides an Extract() method which extracts the FunctionPrototype
- * for a given function. Can be used for both normal functions and member
- * functions through the specializations.
- *
- * We cannot use class names as used in our code (e.g. std::string), as they
- * are not necessarily the same name used when compiled. Therefore, we get
- * the mangled name of the type using typeid (in GCC), and demangle that name
- * to reach the actual name (e.g. std::basic_string<...> rather than
- * std::string).
+ * Type of pointers to the real function of function type T, i.e. the function
+ * which is called by the wrapper when there is no fake. Member functions
+ * receive the object as their first argument.
  */
-template <typename T> struct PrototypeExtractor;
+template <typename T> struct RealFunctionType;
 
-/**
- * PrototypeExtractor specialization for member functions
- */
 template <typename T, typename R , typename ...Args>
-struct PrototypeExtractor<R (T::*)(Args...)>
+struct RealFunctionType<R (T::*)(Args...)>
 {
-    typedef std::function<R (T *o, Args... args)> FakeFunction;
-
-    static FunctionPrototype Extract(const std::string &func_name,
-        uint32_t fq = internal::Qualifiers::NO_QUAL);
+    typedef R (*type)(T *o, Args... args);
 };
 
-/**
- * PrototypeExtractor specialization for normal functions and static member
- * functions
- */
 template <typename R , typename ...Args>
-struct PrototypeExtractor<R (*)(Args...)>
+struct RealFunctionType<R (*)(Args...)>
 {
-    typedef std::function<R (Args... args)> FakeFunction;
-    typedef R (*FuncPtrType)(Args...);
-
-    static FunctionPrototype Extract(const std::string &func_name,
-        uint32_t fq = internal::Qualifiers::NO_QUAL);
-
-    template <typename Class>
-    static FunctionPrototype Extract(const std::string &func_name,
-        uint32_t fq = internal::Qualifiers::NO_QUAL);
+    typedef R (*type)(Args... args);
 };
 
-
 /**
  * Collects prototypes of all wrapped functions, to be used by bind_fakes
  */
 class WrapperBase
 {
     public:
-        typedef std::multimap<std::string, FunctionPrototype> Prototypes;
+        /// multimap of function names to their prototypes, defined below
+        class Prototypes;
         typedef std::pair<void *, std::type_index> FunctionKey;
-        typedef std::map<FunctionKey, WrapperBase *> FunctionWrappers;
 
     public:
         /**
@@ -425,30 +375,36 @@ class WrapperBase
          */
         static const Prototypes &WrappedFunctions();
 
+        /**
+         * Add a wrapped function prototype without a wrapper object, e.g. one
+         * read from a prototype manifest by bind_fakes
+         */
+        static void AddPrototype(FunctionPrototype prototype);
+
         /**
          * Add wrapped function prototype and alias
          */
         WrapperBase(std::string alias, FunctionKey key,
-            FunctionPrototype prototype)
-        {
-            prototype.alias = alias;
-            AddFunction(key, prototype);
-        }
+            FunctionPrototype prototype);
+
+        /**
+         * Register the wrapper object without its prototype, which is read
+         * from prototype notes by bind_fakes (POWERFAKE_COMPACT_WRAPPERS)
+         */
+        explicit WrapperBase(FunctionKey key);
 
     protected:
-        template <typename RetType>
-        static RetType *WrapperObject(FunctionKey key)
-        {
-            auto w = wrappers->find(key);
-            if (w == wrappers->end())
-                throw std::invalid_argument("Wrapped function with the given "
-                        "key not found");
-            return static_cast<RetType *>(w->second);
-        }
+        /**
+         * @return the wrapper object of the function with the given key
+         * @throw std::invalid_argument if the function is not wrapped
+         */
+        static WrapperBase *FindWrapper(FunctionKey key);
 
         void AddFunction(FunctionKey func_key, FunctionPrototype sig);
 
     private:
+        class FunctionWrappers;
+
         static Prototypes *wrapped_funcs;
         static FunctionWrappers *wrappers;
 };
@@ -466,27 +422,22 @@ template <typename FuncType>
 class Wrapper: public WrapperBase
 {
     public:
-        typedef typename PrototypeExtractor<FuncType>::FakeFunction FakeFunction;
+        typedef typename FakeFunctionType<FuncType>::type FakeFunction;
+        typedef typename RealFunctionType<FuncType>::type RealFunction;
 
     public:
         /**
-         * Add wrapped function prototype and alias
+         * Add wrapped function prototype and alias; defined below, as they
+         * need PrototypeExtractor
          */
         Wrapper(std::string alias, FuncType func_ptr, uint32_t fq,
-            std::string func_name) :
-                WrapperBase(alias, FuncKey(func_ptr),
-                    PrototypeExtractor<FuncType>::Extract(func_name, fq))
-        {
-        }
+            std::string func_name);
 
         template<typename Class>
         Wrapper(internal::type_identity<Class>, std::string alias,
-            FuncType func_ptr, uint32_t fq, std::string func_name) :
-                WrapperBase(alias, FuncKey(func_ptr),
-                    PrototypeExtractor<FuncType>::template Extract<Class>(
-                        func_name, fq))
-        {
-        }
+            FuncType func_ptr, uint32_t fq, std::string func_name);
+
+        explicit Wrapper(FuncType func_ptr): WrapperBase(FuncKey(func_ptr)) {}
 
         bool Callable() const { return static_cast<bool>(fake); }
 
@@ -496,13 +447,44 @@ class Wrapper: public WrapperBase
             return fake(std::forward<Args>(args)...);
         }
 
+        /**
+         * Calls the fake function from the wrapper function of @p real_func,
+         * so that the fake can call the real function using CallReal()
+         */
+        template <typename ...Args>
+        typename FakeFunction::result_type CallFake(RealFunction real_func,
+            Args&&... args) const
+        {
+            real.store(real_func, std::memory_order_relaxed);
+            return fake(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Calls the real function, e.g. from a fake function which calls
+         * through to the real one
+         * @throw std::logic_error if the wrapper function has not called any
+         * fake yet, so the real function is unknown
+         */
+        template <typename ...Args>
+        typename FakeFunction::result_type CallReal(Args&&... args) const
+        {
+            RealFunction real_func = real.load(std::memory_order_relaxed);
+            if (!real_func)
+                throw std::logic_error("Real function is not available");
+            return real_func(std::forward<Args>(args)...);
+        }
+
         static Wrapper &WrapperObject(FuncType func)
         {
-            return *WrapperBase::WrapperObject<Wrapper>(FuncKey(func));
+            return *static_cast<Wrapper *>(FindWrapper(FuncKey(func)));
         }
 
     private:
         FakeFunction fake;
+        /// set by the wrapper function when calling the fake, as referring to
+        /// the real function elsewhere would prevent linking the wrapper
+        /// objects into bind_fakes helpers
+        mutable std::atomic<RealFunction> real { nullptr };
         friend class internal::Fake<FuncType>;
 
         static FunctionKey FuncKey(FuncType func_ptr)
@@ -518,6 +500,226 @@ class Wrapper: public WrapperBase
 
 } // namespace internal
 
+// MakeFake implementations
+template <typename Signature, typename Functor>
+static FakePtr MakeFake(Signature *func_ptr, Functor f)
+{
+    typedef internal::remove_func_cv_t<Signature *> FuncType;
+    return std::make_unique<internal::Fake<FuncType>>(
+            internal::Wrapper<FuncType>::WrapperObject(func_ptr), f);
+}
+
+template<typename Signature, typename Class, typename Functor>
+static FakePtr MakeFake(Signature Class::*func_ptr, Functor f)
+{
+    typedef internal::remove_func_cv_t<Signature Class::*> FuncType;
+    return std::make_unique<internal::Fake<FuncType>>(
+        internal::Wrapper<FuncType>::WrapperObject(internal::unify_pmf(func_ptr)), f);
+}
+
+template <typename PrivateMemberTag, typename Functor>
+static FakePtr MakeFake(Functor f)
+{
+    return MakeFake(GetAddress(PrivateMemberTag()), f);
+}
+
+}  // namespace PowerFake
+
+namespace PowerFake
+{
+
+/**
+ * Define a wrapper for the given function. For normal functions, it should be
+ * called with the function name, e.g.:
+ *      WRAP_FUNCTION(MyNameSpace::MyClass::MyFunction);
+ * For overloaded function, you need to specify the function signature so
+ * that the target function can be selected among the overloaded ones:
+ *      WRAP_FUNCTION(void (MyNameSpace::MyClass::*)(int, float),
+ *          MyNameSpace::MyClass::MyFunction)
+ */
+#define WRAP_FUNCTION(...) \
+    SELECT_3RD(__VA_ARGS__, WRAP_FUNCTION_2, WRAP_FUNCTION_1)(__VA_ARGS__)
+
+#define WRAP_STATIC_MEMBER(...) \
+    SELECT_4TH(__VA_ARGS__, WRAP_STATIC_MEMBER_2, WRAP_STATIC_MEMBER_1)(__VA_ARGS__)
+
+#define WRAP_PRIVATE_MEMBER(...) \
+    SELECT_3RD(__VA_ARGS__, WRAP_PRIVATE_MEMBER_2, WRAP_PRIVATE_MEMBER_1)(__VA_ARGS__)
+
+
+namespace internal
+{
+
+std::string ToStr(uint32_t q, bool mangled = false);
+
+/**
+ * Stores components of a function prototype and the function alias
+ */
+struct FunctionPrototype
+{
+    FunctionPrototype(std::string ret, std::string name, std::string params,
+        uint32_t qual, std::string alias = "") :
+            return_type(ret), name(name), params(params), qual(qual),
+            alias(alias)
+    {
+    }
+
+    std::string Str() const
+    {
+        return return_type + ' ' + name + params + ' ' + internal::ToStr(qual);
+    }
+
+    std::string return_type;
+    std::string name;
+    std::string params;
+    uint32_t qual;
+    std::string alias;
+};
+
+/// name of the section containing PrototypeNote records
+#define POWERFAKE_NOTE_SECTION ".note.powerfake"
+/// owner name of PrototypeNote records
+#define POWERFAKE_NOTE_NAME "PowerFake"
+#define POWERFAKE_NOTE_TYPE 1
+
+/**
+ * A compile time record of a wrapped function, stored in an ELF note section
+ * of wrapper objects, so that bind_fakes can find wrapped functions without
+ * running static initializers. It contains the alias, the function name and
+ * its qualifiers; the function type (and the class of static member
+ * functions) is recorded in the symbol name of the prototype_marker<>
+ * instantiation with the same alias tag.
+ *
+ * @tparam N size of strings: alias and function name, separated by '\0'
+ */
+template <std::size_t N>
+struct PrototypeNote
+{
+    uint32_t namesz;
+    uint32_t descsz;
+    uint32_t type;
+    char name[(sizeof(POWERFAKE_NOTE_NAME) + 3) / 4 * 4];
+    // desc
+    uint32_t qual;
+    char strings[(N + 3) / 4 * 4];
+};
+
+template <typename AliasTag, typename FuncType, typename Class>
+char prototype_marker = 0;
+
+/**
+ * This class provides an Extract() method which extracts the FunctionPrototype
+ * for a given function. Can be used for both normal functions and member
+ * functions through the specializations.
+ *
+ * We cannot use class names as used in our code (e.g. std::string), as they
+ * are not necessarily the same name used when compiled. Therefore, we get
+ * the mangled name of the type using typeid (in GCC), and demangle that name
+ * to reach the actual name (e.g. std::basic_string<...> rather than
+ * std::string).
+ */
+template <typename T> struct PrototypeExtractor;
+
+/**
+ * PrototypeExtractor specialization for member functions
+ */
+template <typename T, typename R , typename ...Args>
+struct PrototypeExtractor<R (T::*)(Args...)>
+{
+    typedef typename FakeFunctionType<R (T::*)(Args...)>::type FakeFunction;
+
+    static FunctionPrototype Extract(const std::string &func_name,
+        uint32_t fq = internal::Qualifiers::NO_QUAL);
+};
+
+/**
+ * PrototypeExtractor specialization for normal functions and static member
+ * functions
+ */
+template <typename R , typename ...Args>
+struct PrototypeExtractor<R (*)(Args...)>
+{
+    typedef typename FakeFunctionType<R (*)(Args...)>::type FakeFunction;
+    typedef R (*FuncPtrType)(Args...);
+
+    static FunctionPrototype Extract(const std::string &func_name,
+        uint32_t fq = internal::Qualifiers::NO_QUAL);
+
+    template <typename Class>
+    static FunctionPrototype Extract(const std::string &func_name,
+        uint32_t fq = internal::Qualifiers::NO_QUAL);
+};
+
+
+
+/**
+ * Prototypes of wrapped functions, keyed by function name without scopes
+ */
+class WrapperBase::Prototypes:
+    public std::multimap<std::string, FunctionPrototype>
+{
+};
+
+inline WrapperBase::WrapperBase(std::string alias, FunctionKey key,
+    FunctionPrototype prototype)
+{
+    prototype.alias = alias;
+    AddFunction(key, prototype);
+}
+
+template <typename FuncType>
+Wrapper<FuncType>::Wrapper(std::string alias, FuncType func_ptr, uint32_t fq,
+    std::string func_name) :
+        WrapperBase(alias, FuncKey(func_ptr),
+            PrototypeExtractor<FuncType>::Extract(func_name, fq))
+{
+}
+
+template <typename FuncType>
+template <typename Class>
+Wrapper<FuncType>::Wrapper(internal::type_identity<Class>, std::string alias,
+    FuncType func_ptr, uint32_t fq, std::string func_name) :
+        WrapperBase(alias, FuncKey(func_ptr),
+            PrototypeExtractor<FuncType>::template Extract<Class>(func_name,
+                fq))
+{
+}
+
+/**
+ * Calls the fake function of a wrapper if set, otherwise the real function.
+ * Compact wrappers (POWERFAKE_COMPACT_WRAPPERS) only forward to this function
+ * with their wrapper object and real function, so that this code is shared
+ * among all wrapped functions with the same signature rather than being
+ * instantiated for each of them.
+ */
+template <typename T> struct WrapperDispatch;
+
+template <typename T, typename R , typename ...Args>
+struct WrapperDispatch<R (T::*)(Args...)>
+{
+    [[gnu::noinline]] static R Call(const Wrapper<R (T::*)(Args...)> &w,
+        R (*real)(T *o, Args... args), T *o, Args... args)
+    {
+        if (w.Callable())
+            return w.CallFake(real, o, std::forward<Args>(args)...);
+        return real(o, std::forward<Args>(args)...);
+    }
+};
+
+template <typename R , typename ...Args>
+struct WrapperDispatch<R (*)(Args...)>
+{
+    [[gnu::noinline]] static R Call(const Wrapper<R (*)(Args...)> &w,
+        R (*real)(Args... args), Args... args)
+    {
+        if (w.Callable())
+            return w.CallFake(real, std::forward<Args>(args)...);
+        return real(std::forward<Args>(args)...);
+    }
+};
+
+} // namespace internal
+
 
 // helper macors
 #define TMP_POSTFIX         __end__
@@ -553,7 +755,7 @@ class Wrapper: public WrapperBase
         { \
             R TMP_REAL_NAME(ALIAS)(T *o, Args... args); \
             if (ALIAS.Callable()) \
-                return ALIAS.Call(o, args...); \
+                return ALIAS.CallFake(TMP_REAL_NAME(ALIAS), o, args...); \
             return TMP_REAL_NAME(ALIAS)(o, args...); \
         } \
     }; \
@@ -564,7 +766,7 @@ class Wrapper: public WrapperBase
         { \
             R TMP_REAL_NAME(ALIAS)(Args... args); \
             if (ALIAS.Callable()) \
-                return ALIAS.Call(args...); \
+                return ALIAS.CallFake(TMP_REAL_NAME(ALIAS), args...); \
             return TMP_REAL_NAME(ALIAS)(args...); \
         } \
     }; \
@@ -574,19 +776,96 @@ class Wrapper: public WrapperBase
      * linker by bind_fakes binary. */ \
     template class wrapper_##ALIAS<PowerFake::internal::remove_func_cv_t<FTYPE>>
 
+/**
+ * Same as CREATE_WRAPPER_FUNCTION(), but wrapper functions only forward their
+ * arguments to the shared WrapperDispatch<>::Call()
+ */
+#define CREATE_COMPACT_WRAPPER_FUNCTION(FTYPE, ALIAS) \
+    template <typename T> struct wrapper_##ALIAS; \
+    template <typename T, typename R , typename ...Args> \
+    struct wrapper_##ALIAS<R (T::*)(Args...)> \
+    { \
+        static R TMP_WRAPPER_NAME(ALIAS)(T *o, Args... args) \
+        { \
+            R TMP_REAL_NAME(ALIAS)(T *o, Args... args); \
+            return PowerFake::internal::WrapperDispatch<R (T::*)(Args...)>::Call( \
+                ALIAS, TMP_REAL_NAME(ALIAS), o, std::forward<Args>(args)...); \
+        } \
+    }; \
+    template <typename R , typename ...Args> \
+    struct wrapper_##ALIAS<R (*)(Args...)> \
+    { \
+        static R TMP_WRAPPER_NAME(ALIAS)(Args... args) \
+        { \
+            R TMP_REAL_NAME(ALIAS)(Args... args); \
+            return PowerFake::internal::WrapperDispatch<R (*)(Args...)>::Call( \
+                ALIAS, TMP_REAL_NAME(ALIAS), std::forward<Args>(args)...); \
+        } \
+    }; \
+    template class wrapper_##ALIAS<PowerFake::internal::remove_func_cv_t<FTYPE>>
+
+
+/**
+ * Define PrototypeNote record for function FNAME with type FTYPE and alias
+ * ALIAS. FCLASS is the class of static member functions, or void.
+ * Note records are aligned explicitly, so that they are not padded.
+ * The prototype_marker<> is instantiated by referring to it from a used
+ * variable rather than by an explicit instantiation, which is only allowed in
+ * PowerFake::internal namespace, so that it can be used in any namespace.
+ */
+#define DEFINE_PROTOTYPE_NOTE(FCLASS, FTYPE, FNAME, ALIAS) \
+    struct ALIAS##PowerFakeNoteTag; \
+    [[gnu::used]] static const char *const ALIAS##PowerFakeMarker = \
+        &PowerFake::internal::prototype_marker<ALIAS##PowerFakeNoteTag, \
+            PowerFake::internal::remove_func_cv_t<FTYPE>, FCLASS>; \
+    [[gnu::used, gnu::section(POWERFAKE_NOTE_SECTION)]] alignas(4) static const \
+        PowerFake::internal::PrototypeNote<sizeof(#ALIAS "\0" #FNAME)> \
+        ALIAS##PowerFakeNote = { sizeof(POWERFAKE_NOTE_NAME), \
+            4 + sizeof(#ALIAS "\0" #FNAME), POWERFAKE_NOTE_TYPE, \
+            POWERFAKE_NOTE_NAME, \
+            PowerFake::internal::func_cv_processor<FTYPE>::q, \
+            #ALIAS "\0" #FNAME };
 
 #define DEFINE_WRAPPER_OBJECT(FTYPE, FNAME, FADDR, ALIAS) \
+    DEFINE_PROTOTYPE_NOTE(void, FTYPE, FNAME, ALIAS) \
     static PowerFake::internal::Wrapper<PowerFake::internal::remove_func_cv_t<FTYPE>> \
         ALIAS(#ALIAS, PowerFake::internal::unify_pmf<FTYPE>(FADDR), \
             PowerFake::internal::func_qual_v<FTYPE>, #FNAME);
 
 #define DEFINE_WRAPPER_OBJECT2(FCLASS, FTYPE, FNAME, ALIAS) \
+    DEFINE_PROTOTYPE_NOTE(FCLASS, FTYPE, FNAME, ALIAS) \
     static PowerFake::internal::Wrapper<PowerFake::internal::remove_func_cv_t<FTYPE>> \
         ALIAS(PowerFake::internal::type_identity<FCLASS>(), \
                 #ALIAS, PowerFake::internal::unify_pmf<FTYPE>(&FNAME), \
                 PowerFake::internal::func_qual_v<FTYPE>, #FNAME);
 
-#ifndef BIND_FAKES
+/**
+ * Wrapper objects of compact wrappers only register themselves; the prototype
+ * is only recorded in the PrototypeNote, so no PrototypeExtractor code and no
+ * strings are generated for them
+ */
+#define DEFINE_COMPACT_WRAPPER_OBJECT(FCLASS, FTYPE, FNAME, FADDR, ALIAS) \
+    DEFINE_PROTOTYPE_NOTE(FCLASS, FTYPE, FNAME, ALIAS) \
+    static PowerFake::internal::Wrapper<PowerFake::internal::remove_func_cv_t<FTYPE>> \
+        ALIAS(PowerFake::internal::unify_pmf<FTYPE>(FADDR));
+
+#if defined(POWERFAKE_COMPACT_WRAPPERS) && !defined(BIND_FAKES)
+
+/**
+ * Compact wrappers, which reduce the code generated for each wrapped function:
+ * the fake/real dispatch code is shared among functions with the same
+ * signature, and wrapper objects are registered without their prototypes.
+ * bind_fakes reads their prototypes from the notes.
+ */
+#define WRAP_FUNCTION_BASE(FTYPE, FNAME, FADDR, ALIAS) \
+    DEFINE_COMPACT_WRAPPER_OBJECT(void, FTYPE, FNAME, FADDR, ALIAS) \
+    CREATE_COMPACT_WRAPPER_FUNCTION(FTYPE, ALIAS)
+
+#define WRAP_STATIC_MEMBER_BASE(FCLASS, FTYPE, FNAME, ALIAS) \
+    DEFINE_COMPACT_WRAPPER_OBJECT(FCLASS, FTYPE, FNAME, &FNAME, ALIAS) \
+    CREATE_COMPACT_WRAPPER_FUNCTION(FTYPE, ALIAS)
+
+#elif !defined(BIND_FAKES)
 
 /**
  * Define wrapper for function FNAME with type FTYPE and alias ALIAS. Must be
@@ -679,29 +958,6 @@ class Wrapper: public WrapperBase
     WRAP_PRIVATE_MEMBER_1_HELPER(FNAME, \
         BUILD_NAME(POWRFAKE_WRAP_NAMESPACE, _alias_, __LINE__))
 
-// MakeFake implementations
-template <typename Signature, typename Functor>
-static FakePtr MakeFake(Signature *func_ptr, Functor f)
-{
-    typedef internal::remove_func_cv_t<Signature *> FuncType;
-    return std::make_unique<internal::Fake<FuncType>>(
-            internal::Wrapper<FuncType>::WrapperObject(func_ptr), f);
-}
-
-template<typename Signature, typename Class, typename Functor>
-static FakePtr MakeFake(Signature Class::*func_ptr, Functor f)
-{
-    typedef internal::remove_func_cv_t<Signature Class::*> FuncType;
-    return std::make_unique<internal::Fake<FuncType>>(
-        internal::Wrapper<FuncType>::WrapperObject(internal::unify_pmf(func_ptr)), f);
-}
-
-template <typename PrivateMemberTag, typename Functor>
-static FakePtr MakeFake(Functor f)
-{
-    return MakeFake(GetAddress(PrivateMemberTag()), f);
-}
-
 namespace internal
 {
 
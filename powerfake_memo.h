@@ -0,0 +1,282 @@
+/*
+ * powerfake_memo.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef POWERFAKE_MEMO_H_
+#define POWERFAKE_MEMO_H_
+
+/*
+ * Memoizing fakes: MakeMemoFake() creates a fake which calls the real function
+ * for new arguments, and returns the cached result for arguments it has seen
+ * before. It can be used for pure but expensive functions called repeatedly
+ * by tests. Arguments are encoded by Codec<> specializations of
+ * powerfake_record.h to find cached results.
+ *
+ * Results of member functions are cached per object, keyed by the object
+ * address rather than its state. A new object allocated at the address of a
+ * destroyed one gets the results cached for the old object, so member
+ * functions should only be memoized while their objects are alive (e.g.
+ * create the fake after the objects and destroy it before them, which also
+ * drops its cache). Like replay fakes, cache hits do not set out-parameters.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "powerfake_record.h"
+
+namespace PowerFake
+{
+
+/**
+ * Policy for evicting cached results when the cache is full
+ */
+enum class EvictionPolicy
+{
+    /// evicts the least recently used result; each hit updates the order
+    /// under an exclusive lock
+    LRU,
+    /// evicts a result not used since the last pass of the clock hand; hits
+    /// only set a flag, so they run concurrently
+    CLOCK
+};
+
+/**
+ * A fixed capacity cache of values of type V keyed by strings, which can be
+ * used by several threads. Lookups take a shared lock (an exclusive one for
+ * hits with LRU policy), and insertions take an exclusive lock.
+ */
+template <typename V>
+class MemoCache
+{
+    public:
+        MemoCache(size_t capacity, EvictionPolicy policy):
+            capacity(std::max<size_t>(capacity, 1)), policy(policy)
+        {
+            entries.reserve(this->capacity);
+        }
+
+        MemoCache(const MemoCache &) = delete;
+        MemoCache &operator=(const MemoCache &) = delete;
+
+        /**
+         * @return the cached value of @p key, if any
+         */
+        std::optional<V> Find(const std::string &key)
+        {
+            if (policy == EvictionPolicy::LRU)
+            {
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                auto e = index.find(key);
+                if (e == index.end())
+                    return std::nullopt;
+                auto &entry = *entries[e->second];
+                lru.splice(lru.begin(), lru, entry.lru_pos);
+                return entry.value;
+            }
+
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto e = index.find(key);
+            if (e == index.end())
+                return std::nullopt;
+            auto &entry = *entries[e->second];
+            entry.referenced.store(true, std::memory_order_relaxed);
+            return entry.value;
+        }
+
+        /**
+         * Caches @p value for @p key, evicting another value if the cache is
+         * full. If @p key is already cached (e.g. by another thread), the
+         * cached value is kept.
+         */
+        void Insert(const std::string &key, V value)
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            if (index.count(key))
+                return;
+
+            size_t slot = entries.size();
+            if (slot < capacity)
+            {
+                entries.push_back(std::make_unique<Entry>());
+                if (policy == EvictionPolicy::LRU)
+                    entries[slot]->lru_pos = lru.insert(lru.begin(), slot);
+            }
+            else
+            {
+                slot = Victim();
+                index.erase(entries[slot]->key);
+                if (policy == EvictionPolicy::LRU)
+                    lru.splice(lru.begin(), lru, entries[slot]->lru_pos);
+            }
+            auto &entry = *entries[slot];
+            entry.key = key;
+            entry.value.emplace(std::move(value));
+            entry.referenced.store(false, std::memory_order_relaxed);
+            index.emplace(entry.key, slot);
+        }
+
+        size_t Size() const
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return index.size();
+        }
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            std::optional<V> value;
+            /// used since the last pass of the clock hand (CLOCK)
+            std::atomic<bool> referenced { false };
+            /// position in lru list (LRU)
+            std::list<size_t>::iterator lru_pos;
+        };
+
+        const size_t capacity;
+        const EvictionPolicy policy;
+        std::vector<std::unique_ptr<Entry>> entries;
+        /// keys are views of Entry::key
+        std::unordered_map<std::string_view, size_t> index;
+        /// slots in the order of use, the most recent one first (LRU)
+        std::list<size_t> lru;
+        /// clock hand (CLOCK)
+        size_t hand = 0;
+        mutable std::shared_mutex mutex;
+
+        /**
+         * @return the slot to be evicted; the cache should be full
+         */
+        size_t Victim()
+        {
+            if (policy == EvictionPolicy::LRU)
+                return lru.back();
+            // gives a second chance to referenced entries
+            while (entries[hand]->referenced.exchange(false,
+                    std::memory_order_relaxed))
+                hand = (hand + 1) % capacity;
+            size_t victim = hand;
+            hand = (hand + 1) % capacity;
+            return victim;
+        }
+};
+
+namespace internal
+{
+
+/**
+ * Returns the cached result of @p key, or caches the result of @p call
+ */
+template <typename R, typename Call>
+R MemoCall(MemoCache<std::decay_t<R>> &cache, const std::string &key,
+    Call call)
+{
+    if (auto result = cache.Find(key))
+        return std::move(*result);
+    // the real function is called without holding any lock
+    std::decay_t<R> result = call();
+    cache.Insert(key, result);
+    return result;
+}
+
+/**
+ * Creates memoizing fake functions for function type T
+ */
+template <typename T> struct Memoizer;
+
+template <typename T, typename R , typename ...Args>
+struct Memoizer<R (T::*)(Args...)>
+{
+    typedef Wrapper<R (T::*)(Args...)> WT;
+    typedef MemoCache<std::decay_t<R>> Cache;
+
+    static typename WT::FakeFunction Memo(const WT &w,
+        std::shared_ptr<Cache> cache)
+    {
+        // results are cached per object address, see the comment at the top
+        return [&w, cache](T *o, Args... args) -> R {
+            std::string key(reinterpret_cast<const char *>(&o), sizeof(o));
+            EncodeArgs(key, args...);
+            return MemoCall<R>(*cache, key,
+                [&]() -> R { return w.CallReal(o, args...); });
+        };
+    }
+};
+
+template <typename R , typename ...Args>
+struct Memoizer<R (*)(Args...)>
+{
+    typedef Wrapper<R (*)(Args...)> WT;
+    typedef MemoCache<std::decay_t<R>> Cache;
+
+    static typename WT::FakeFunction Memo(const WT &w,
+        std::shared_ptr<Cache> cache)
+    {
+        return [&w, cache](Args... args) -> R {
+            std::string key;
+            EncodeArgs(key, args...);
+            return MemoCall<R>(*cache, key,
+                [&]() -> R { return w.CallReal(args...); });
+        };
+    }
+};
+
+template <typename FuncType>
+typename Wrapper<FuncType>::FakeFunction MakeMemoFunction(
+    const Wrapper<FuncType> &w, size_t capacity, EvictionPolicy policy)
+{
+    typedef typename FakeFunctionType<FuncType>::type::result_type R;
+    static_assert(!std::is_void_v<R> && !std::is_reference_v<R>,
+        "Only functions returning values can be memoized");
+    return Memoizer<FuncType>::Memo(w,
+        std::make_shared<typename Memoizer<FuncType>::Cache>(capacity,
+            policy));
+}
+
+} // namespace internal
+
+/**
+ * Creates a fake which caches the results of the real function by its
+ * arguments, keeping at most @p capacity results. Results of member functions
+ * are cached for each object address separately, so they might be returned
+ * for a different object created at the address of a destroyed one.
+ */
+template <typename Signature>
+static FakePtr MakeMemoFake(Signature *func_ptr, size_t capacity = 1024,
+    EvictionPolicy policy = EvictionPolicy::CLOCK)
+{
+    typedef internal::remove_func_cv_t<Signature *> FuncType;
+    return MakeFake(func_ptr, internal::MakeMemoFunction(
+        internal::Wrapper<FuncType>::WrapperObject(func_ptr), capacity,
+        policy));
+}
+
+template <typename Signature, typename Class>
+static FakePtr MakeMemoFake(Signature Class::*func_ptr,
+    size_t capacity = 1024, EvictionPolicy policy = EvictionPolicy::CLOCK)
+{
+    typedef internal::remove_func_cv_t<Signature Class::*> FuncType;
+    return MakeFake(func_ptr, internal::MakeMemoFunction(
+        internal::Wrapper<FuncType>::WrapperObject(
+            internal::unify_pmf(func_ptr)), capacity, policy));
+}
+
+}  // namespace PowerFake
+
+#endif /* POWERFAKE_MEMO_H_ */
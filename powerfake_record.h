@@ -0,0 +1,459 @@
+/*
+ * powerfake_record.h
+ *
+ *  Created on: ۲۶ مهر ۱۴۰۵
+ *
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#ifndef POWERFAKE_RECORD_H_
+#define POWERFAKE_RECORD_H_
+
+/*
+ * Record and replay fakes: MakeRecordFake() calls the real function and
+ * appends its arguments and result to a call log, and MakeReplayFake()
+ * answers calls from a recorded log without calling the real function. It can
+ * be used to replace slow dependencies (e.g. compression or database queries)
+ * by their recorded results.
+ *
+ * Arguments and results are serialized by Codec<> specializations, which are
+ * provided for arithmetic and enum types, std::string and std::vector<>, and
+ * can be specialized for other types. The object of member functions is not
+ * recorded, and functions returning references cannot be replayed.
+ *
+ * Only the result is recorded: arguments are encoded before the call, and
+ * values written by the real function through reference or pointer
+ * parameters (out-parameters) are neither recorded nor set when replaying.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "powerfake.h"
+
+namespace PowerFake
+{
+
+/**
+ * Serializes values of type T for call logs. Specializations should provide:
+ *      static void Encode(std::string &out, const T &value);
+ *      static T Decode(std::string_view &in);
+ * Decode() consumes the value from the start of @p in, and throws
+ * std::runtime_error if it is truncated. Encoded values are also compared
+ * to find recorded calls, so equal values should have the same encoding.
+ */
+template <typename T, typename Enable = void>
+struct Codec
+{
+    static_assert(sizeof(T) == 0, "No PowerFake::Codec<> specialization for "
+            "the argument or return type");
+};
+
+template <typename T>
+struct Codec<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>
+{
+    static void Encode(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    static T Decode(std::string_view &in)
+    {
+        if (in.size() < sizeof(T))
+            throw std::runtime_error("Truncated value in call log");
+        T value;
+        memcpy(&value, in.data(), sizeof(T));
+        in.remove_prefix(sizeof(T));
+        return value;
+    }
+};
+
+template <>
+struct Codec<std::string>
+{
+    static void Encode(std::string &out, const std::string &value)
+    {
+        Codec<uint32_t>::Encode(out, value.size());
+        out += value;
+    }
+
+    static std::string Decode(std::string_view &in)
+    {
+        uint32_t size = Codec<uint32_t>::Decode(in);
+        if (in.size() < size)
+            throw std::runtime_error("Truncated value in call log");
+        std::string value(in.substr(0, size));
+        in.remove_prefix(size);
+        return value;
+    }
+};
+
+template <typename T>
+struct Codec<std::vector<T>>
+{
+    static void Encode(std::string &out, const std::vector<T> &value)
+    {
+        Codec<uint32_t>::Encode(out, value.size());
+        for (const auto &v: value)
+            Codec<T>::Encode(out, v);
+    }
+
+    static std::vector<T> Decode(std::string_view &in)
+    {
+        uint32_t size = Codec<uint32_t>::Decode(in);
+        std::vector<T> value;
+        value.reserve(std::min<size_t>(size, in.size()));
+        for (uint32_t i = 0; i < size; ++i)
+            value.push_back(Codec<T>::Decode(in));
+        return value;
+    }
+};
+
+/// magic of call log files
+#define POWERFAKE_CALL_LOG_MAGIC "PFCALLS1"
+
+/**
+ * Appends recorded calls to a call log file. Each call is appended with a
+ * single write(), and the magic of a new file is written under an exclusive
+ * flock(), so several processes (e.g. forked test processes) can record into
+ * the same file.
+ *
+ * Log format: POWERFAKE_CALL_LOG_MAGIC, followed by records of key size and
+ * result size (uint32_t each), the key and the result. Keys are the function
+ * id, a '\0' and the encoded arguments.
+ */
+class CallRecorder
+{
+    public:
+        /**
+         * @throw std::runtime_error if the file cannot be opened
+         */
+        explicit CallRecorder(const std::string &file_name)
+        {
+            fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open call log: " + file_name);
+            // another recorder might be writing the magic of the same file
+            if (flock(fd, LOCK_EX) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Cannot lock call log: " + file_name);
+            }
+            struct stat st;
+            bool empty = fstat(fd, &st) == 0 && st.st_size == 0;
+            if (empty && write(fd, POWERFAKE_CALL_LOG_MAGIC,
+                    strlen(POWERFAKE_CALL_LOG_MAGIC))
+                    != static_cast<ssize_t>(strlen(POWERFAKE_CALL_LOG_MAGIC)))
+            {
+                close(fd);
+                throw std::runtime_error("Cannot write call log: "
+                    + file_name);
+            }
+            flock(fd, LOCK_UN);
+        }
+
+        ~CallRecorder() { close(fd); }
+
+        CallRecorder(const CallRecorder &) = delete;
+        CallRecorder &operator=(const CallRecorder &) = delete;
+
+        void Append(std::string_view key, std::string_view result)
+        {
+            std::string record;
+            Codec<uint32_t>::Encode(record, key.size());
+            Codec<uint32_t>::Encode(record, result.size());
+            record += key;
+            record += result;
+            Write(record);
+        }
+
+    private:
+        int fd;
+
+        void Write(std::string_view data)
+        {
+            if (write(fd, data.data(), data.size())
+                    != static_cast<ssize_t>(data.size()))
+                throw std::runtime_error("Cannot write call log");
+        }
+};
+
+/**
+ * Answers calls from a call log, which is mapped into memory and indexed by
+ * call keys. If a call is recorded more than once, recorded results are
+ * returned in order, and the last one is repeated afterwards.
+ */
+class CallReplayer
+{
+    public:
+        /**
+         * @throw std::runtime_error if the file cannot be read or is not a
+         * valid call log
+         */
+        explicit CallReplayer(const std::string &file_name)
+        {
+            int fd = open(file_name.c_str(), O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0)
+            {
+                if (fd >= 0)
+                    close(fd);
+                throw std::runtime_error("Cannot open call log: " + file_name);
+            }
+            size = st.st_size;
+            if (size)
+                data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (size && data == MAP_FAILED)
+                throw std::runtime_error("Cannot map call log: " + file_name);
+
+            std::string_view log(size ? static_cast<const char *>(data) : "",
+                size);
+            const std::string_view magic = POWERFAKE_CALL_LOG_MAGIC;
+            if (log.substr(0, magic.size()) != magic)
+            {
+                Unmap();
+                throw std::runtime_error("Not a call log: " + file_name);
+            }
+            log.remove_prefix(magic.size());
+            try
+            {
+                while (!log.empty())
+                {
+                    uint32_t key_size = Codec<uint32_t>::Decode(log);
+                    uint32_t result_size = Codec<uint32_t>::Decode(log);
+                    if (log.size() < size_t(key_size) + result_size)
+                        throw std::runtime_error("Truncated call log: "
+                            + file_name);
+                    index[log.substr(0, key_size)].results.push_back(
+                        log.substr(key_size, result_size));
+                    log.remove_prefix(key_size + result_size);
+                }
+            }
+            catch (...)
+            {
+                Unmap();
+                throw;
+            }
+        }
+
+        ~CallReplayer() { Unmap(); }
+
+        CallReplayer(const CallReplayer &) = delete;
+        CallReplayer &operator=(const CallReplayer &) = delete;
+
+        /**
+         * @return the next recorded result of the call with the given key
+         * @throw std::runtime_error if the call is not recorded
+         */
+        std::string_view Find(std::string_view key)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto call = index.find(key);
+            if (call == index.end())
+                throw std::runtime_error("Call is not recorded: "
+                    + std::string(key.substr(0, key.find('\0'))));
+            auto &entry = call->second;
+            if (entry.next + 1 < entry.results.size())
+                return entry.results[entry.next++];
+            return entry.results.back();
+        }
+
+    private:
+        struct Entry
+        {
+            std::vector<std::string_view> results;
+            size_t next = 0;
+        };
+
+        void *data = MAP_FAILED;
+        size_t size = 0;
+        std::unordered_map<std::string_view, Entry> index;
+        std::mutex mutex;
+
+        void Unmap()
+        {
+            if (data != MAP_FAILED)
+                munmap(data, size);
+            data = MAP_FAILED;
+        }
+};
+
+namespace internal
+{
+
+/**
+ * Appends encoded @p args to @p out
+ */
+template <typename ...Args>
+void EncodeArgs(std::string &out, const Args &...args)
+{
+    (Codec<std::decay_t<Args>>::Encode(out, args), ...);
+}
+
+/**
+ * @return the key of a call: @p id, '\0' and encoded @p args
+ */
+template <typename ...Args>
+std::string CallKey(const std::string &id, const Args &...args)
+{
+    std::string key = id;
+    key += '\0';
+    EncodeArgs(key, args...);
+    return key;
+}
+
+/**
+ * Calls @p call and records its result with @p key
+ */
+template <typename R, typename Call>
+R RecordCall(CallRecorder &recorder, const std::string &key, Call call)
+{
+    if constexpr (std::is_void_v<R>)
+    {
+        call();
+        recorder.Append(key, std::string_view());
+    }
+    else
+    {
+        R r = call();
+        std::string result;
+        Codec<std::decay_t<R>>::Encode(result, r);
+        recorder.Append(key, result);
+        return r;
+    }
+}
+
+template <typename R>
+R ReplayCall(CallReplayer &replayer, const std::string &key)
+{
+    static_assert(!std::is_reference_v<R>, "Functions returning references "
+            "cannot be replayed");
+    auto result = replayer.Find(key);
+    if constexpr (!std::is_void_v<R>)
+        return Codec<std::decay_t<R>>::Decode(result);
+}
+
+/**
+ * Creates record and replay fake functions for function type T
+ */
+template <typename T> struct RecordReplay;
+
+template <typename T, typename R , typename ...Args>
+struct RecordReplay<R (T::*)(Args...)>
+{
+    typedef Wrapper<R (T::*)(Args...)> WT;
+
+    static typename WT::FakeFunction Recorder(const WT &w,
+        CallRecorder &recorder, std::string id)
+    {
+        return [&w, &recorder, id](T *o, Args... args) -> R {
+            // arguments are encoded before the call, which might modify them
+            const std::string key = CallKey(id, args...);
+            return RecordCall<R>(recorder, key,
+                [&]() -> R { return w.CallReal(o, args...); });
+        };
+    }
+
+    static typename WT::FakeFunction Replayer(CallReplayer &replayer,
+        std::string id)
+    {
+        return [&replayer, id](T *, Args... args) -> R {
+            return ReplayCall<R>(replayer, CallKey(id, args...));
+        };
+    }
+};
+
+template <typename R , typename ...Args>
+struct RecordReplay<R (*)(Args...)>
+{
+    typedef Wrapper<R (*)(Args...)> WT;
+
+    static typename WT::FakeFunction Recorder(const WT &w,
+        CallRecorder &recorder, std::string id)
+    {
+        return [&w, &recorder, id](Args... args) -> R {
+            const std::string key = CallKey(id, args...);
+            return RecordCall<R>(recorder, key,
+                [&]() -> R { return w.CallReal(args...); });
+        };
+    }
+
+    static typename WT::FakeFunction Replayer(CallReplayer &replayer,
+        std::string id)
+    {
+        return [&replayer, id](Args... args) -> R {
+            return ReplayCall<R>(replayer, CallKey(id, args...));
+        };
+    }
+};
+
+} // namespace internal
+
+/**
+ * Creates a fake which calls the real function, and records its calls with
+ * the given @p id into @p recorder. The id should be unique among recorded
+ * functions, e.g. the function name. Out-parameters are not recorded.
+ */
+template <typename Signature>
+static FakePtr MakeRecordFake(Signature *func_ptr, CallRecorder &recorder,
+    std::string id)
+{
+    typedef internal::remove_func_cv_t<Signature *> FuncType;
+    return MakeFake(func_ptr, internal::RecordReplay<FuncType>::Recorder(
+        internal::Wrapper<FuncType>::WrapperObject(func_ptr), recorder, id));
+}
+
+template <typename Signature, typename Class>
+static FakePtr MakeRecordFake(Signature Class::*func_ptr,
+    CallRecorder &recorder, std::string id)
+{
+    typedef internal::remove_func_cv_t<Signature Class::*> FuncType;
+    return MakeFake(func_ptr, internal::RecordReplay<FuncType>::Recorder(
+        internal::Wrapper<FuncType>::WrapperObject(
+            internal::unify_pmf(func_ptr)), recorder, id));
+}
+
+/**
+ * Creates a fake which answers calls from the calls recorded with the given
+ * @p id. Calls which are not recorded throw std::runtime_error, and
+ * out-parameters are left unchanged.
+ */
+template <typename Signature>
+static FakePtr MakeReplayFake(Signature *func_ptr, CallReplayer &replayer,
+    std::string id)
+{
+    typedef internal::remove_func_cv_t<Signature *> FuncType;
+    return MakeFake(func_ptr,
+        internal::RecordReplay<FuncType>::Replayer(replayer, id));
+}
+
+template <typename Signature, typename Class>
+static FakePtr MakeReplayFake(Signature Class::*func_ptr,
+    CallReplayer &replayer, std::string id)
+{
+    typedef internal::remove_func_cv_t<Signature Class::*> FuncType;
+    return MakeFake(func_ptr,
+        internal::RecordReplay<FuncType>::Replayer(replayer, id));
+}
+
+}  // namespace PowerFake
+
+#endif /* POWERFAKE_RECORD_H_ */
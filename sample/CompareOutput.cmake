@@ -0,0 +1,19 @@
+#  Distributed under the Boost Software License, Version 1.0.
+#       (See accompanying file LICENSE_1_0.txt or copy at
+#             http://www.boost.org/LICENSE_1_0.txt)
+
+# Runs EXPECTED and ACTUAL programs, and fails if their output or exit status
+# differ
+execute_process(COMMAND ${EXPECTED} OUTPUT_VARIABLE expected_output
+    ERROR_VARIABLE expected_output RESULT_VARIABLE expected_result)
+execute_process(COMMAND ${ACTUAL} OUTPUT_VARIABLE actual_output
+    ERROR_VARIABLE actual_output RESULT_VARIABLE actual_result)
+
+if(NOT expected_output STREQUAL actual_output)
+    message(FATAL_ERROR "Output of ${ACTUAL} differs from ${EXPECTED}")
+endif()
+if(NOT expected_result STREQUAL actual_result)
+    message(FATAL_ERROR "${ACTUAL} exits with '${actual_result}', while "
+        "${EXPECTED} exits with '${expected_result}'")
+endif()
+message(STATUS "${ACTUAL}: same output as ${EXPECTED}")
@@ -11,11 +11,33 @@
  */
 
 #include "powerfake.h"
+#include "powerfake_memo.h"
+#include "powerfake_record.h"
 #include "Reader.h"
 #include "NMSymbolReader.h"
-
+#include "MangledNameFilter.h"
+#include "ArchiveFile.h"
+#include "FileUtils.h"
+#include "SymbolRenamer.h"
+#include "SymbolIndex.h"
+#include "SymbolPipeline.h"
+#include "BindStats.h"
+#include "CallSiteAnalysis.h"
+#include "PrototypeManifest.h"
+#include "PrototypeNotes.h"
+#include "WrapperShards.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <type_traits>
 #include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/framework.hpp>
 
@@ -24,6 +46,7 @@
 #define private public
 #include "SymbolAliasMap.h"
 #undef private
+#include "BindCache.h"
 
 
 using namespace std;
@@ -48,10 +71,13 @@ struct SampleLibConfig
                 std::string arg = master_suite.argv[i];
                 if (arg == "--sample-lib" && i + 1 < master_suite.argc)
                     sample_lib = master_suite.argv[i+1];
+                if (arg == "--sample-wrap-lib" && i + 1 < master_suite.argc)
+                    sample_wrap_lib = master_suite.argv[i+1];
             }
         }
 
         std::string sample_lib;
+        std::string sample_wrap_lib;
 };
 
 
@@ -142,6 +168,127 @@ BOOST_AUTO_TEST_CASE(FunctionFakeTest)
     BOOST_TEST(!folan.Callable());
 }
 
+int real_dispatch_arg = 0;
+
+void RealDispatchFunction(int a)
+{
+    real_dispatch_arg = a;
+}
+
+BOOST_AUTO_TEST_CASE(WrapperDispatchTest)
+{
+    Wrapper<void (*)(int)> folan(&RealDispatchFunction);
+
+    WrapperDispatch<void (*)(int)>::Call(folan, &RealDispatchFunction, 3);
+    BOOST_TEST(real_dispatch_arg == 3);
+    {
+        int fake_arg = 0;
+        auto myfake = MakeFake(&RealDispatchFunction,
+            [&fake_arg](int a){ fake_arg = a; });
+
+        WrapperDispatch<void (*)(int)>::Call(folan, &RealDispatchFunction, 4);
+        BOOST_TEST(fake_arg == 4);
+        BOOST_TEST(real_dispatch_arg == 3);
+    }
+    WrapperDispatch<void (*)(int)>::Call(folan, &RealDispatchFunction, 5);
+    BOOST_TEST(real_dispatch_arg == 5);
+}
+
+std::string RealRecordFunction(const std::string &s, int n)
+{
+    return s + std::to_string(n);
+}
+
+BOOST_AUTO_TEST_CASE(RecordReplayTest)
+{
+    typedef std::string (*FuncType)(const std::string &, int);
+    Wrapper<FuncType> folan(&RealRecordFunction);
+    const string log_file = "powerfake_record_test.log";
+    remove(log_file.c_str());
+
+    {
+        CallRecorder recorder(log_file);
+        // the magic is written only once for several recorders of a file
+        CallRecorder other(log_file);
+        auto myfake = MakeRecordFake(&RealRecordFunction, recorder, "folan");
+        // the real function is known after the wrapper calls the fake
+        BOOST_CHECK_THROW(folan.CallReal("a", 1), std::logic_error);
+        BOOST_TEST(folan.CallFake(&RealRecordFunction, "a", 1) == "a1");
+        BOOST_TEST(folan.CallFake(&RealRecordFunction, "b", 2) == "b2");
+    }
+
+    CallReplayer replayer(log_file);
+    {
+        auto myfake = MakeReplayFake(&RealRecordFunction, replayer, "folan");
+        BOOST_TEST(folan.Call("b", 2) == "b2");
+        BOOST_TEST(folan.Call("a", 1) == "a1");
+        BOOST_CHECK_THROW(folan.Call("a", 2), std::runtime_error);
+    }
+    remove(log_file.c_str());
+    BOOST_CHECK_THROW(CallReplayer replayer(log_file), std::runtime_error);
+}
+
+int memo_real_calls = 0;
+
+int RealMemoFunction(int a)
+{
+    ++memo_real_calls;
+    return a * 2;
+}
+
+BOOST_AUTO_TEST_CASE(MemoFakeTest)
+{
+    Wrapper<int (*)(int)> folan(&RealMemoFunction);
+
+    for (auto policy: { EvictionPolicy::LRU, EvictionPolicy::CLOCK })
+    {
+        memo_real_calls = 0;
+        auto myfake = MakeMemoFake(&RealMemoFunction, 2, policy);
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 1) == 2);
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 2) == 4);
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 1) == 2);
+        BOOST_TEST(memo_real_calls == 2);
+
+        // 2 is evicted by both policies, since 1 is used after it
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 3) == 6);
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 1) == 2);
+        BOOST_TEST(memo_real_calls == 3);
+        BOOST_TEST(folan.CallFake(&RealMemoFunction, 2) == 4);
+        BOOST_TEST(memo_real_calls == 4);
+    }
+}
+
+struct MemoScaler
+{
+    int factor;
+    int Scale(int a) { return a * factor; }
+};
+
+int RealMemoScale(MemoScaler *o, int a)
+{
+    ++memo_real_calls;
+    return o->Scale(a);
+}
+
+BOOST_AUTO_TEST_CASE(MemoFakeMemberFunctionTest)
+{
+    typedef int (MemoScaler::*FuncType)(int);
+    Wrapper<FuncType> folan(&MemoScaler::Scale);
+    MemoScaler twice { 2 }, thrice { 3 };
+
+    memo_real_calls = 0;
+    auto myfake = MakeMemoFake(&MemoScaler::Scale);
+    BOOST_TEST(folan.CallFake(&RealMemoScale, &twice, 5) == 10);
+    BOOST_TEST(folan.CallFake(&RealMemoScale, &thrice, 5) == 15);
+    BOOST_TEST(folan.CallFake(&RealMemoScale, &twice, 5) == 10);
+    BOOST_TEST(memo_real_calls == 2);
+
+    // results are keyed by the object address, not its state
+    twice.factor = 4;
+    BOOST_TEST(folan.CallFake(&RealMemoScale, &twice, 5) == 10);
+    BOOST_TEST(memo_real_calls == 2);
+}
+
 BOOST_AUTO_TEST_CASE(MemberFunctionSimpleFakeTest)
 {
     Wrapper<TestMemberFuncType> folan("folan", nullptr,
@@ -179,22 +326,49 @@ BOOST_AUTO_TEST_CASE(MemberFunctionFullFakeTest)
 
 BOOST_AUTO_TEST_CASE(PipeReadTest)
 {
-    PipeReader pr("echo 'hi\nhoy\nhey'");
+    PipeReader pr("echo 'hi\nhoy\n\nhey'");
 
-    const char *line = pr.ReadLine();
-    BOOST_TEST(line);
+    string_view line = pr.ReadLine();
+    BOOST_TEST(line.data());
     BOOST_TEST(line == "hi");
 
     line = pr.ReadLine();
-    BOOST_TEST(line);
+    BOOST_TEST(line.data());
     BOOST_TEST(line == "hoy");
 
     line = pr.ReadLine();
-    BOOST_TEST(line);
+    BOOST_TEST(line.data());
+    BOOST_TEST(line.empty());
+
+    line = pr.ReadLine();
+    BOOST_TEST(line.data());
     BOOST_TEST(line == "hey");
+    BOOST_TEST(line.data()[line.size()] == '\0');
 
     line = pr.ReadLine();
-    BOOST_TEST(!line);
+    BOOST_TEST(!line.data());
+}
+
+BOOST_AUTO_TEST_CASE(ChunkedReadTest)
+{
+    // lines crossing chunk boundaries and longer than a chunk, and a last
+    // line without new line character
+    char input[] = "a\nsome long line\n\nbc\nlast";
+    FILE *f = fmemopen(input, sizeof(input) - 1, "r");
+    BOOST_TEST_REQUIRE(f);
+    Reader reader(f, 4);
+
+    const char *expected[] = { "a", "some long line", "", "bc", "last" };
+    for (const char *e: expected)
+    {
+        string_view line = reader.ReadLine();
+        BOOST_TEST_REQUIRE(line.data());
+        BOOST_TEST(line == e);
+        BOOST_TEST(strlen(line.data()) == line.size());
+    }
+    BOOST_TEST(!reader.ReadLine().data());
+    BOOST_TEST(!reader.ReadLine().data());
+    fclose(f);
 }
 
 BOOST_FIXTURE_TEST_CASE(NMReaderTest, SampleLibConfig)
@@ -206,9 +380,9 @@ BOOST_FIXTURE_TEST_CASE(NMReaderTest, SampleLibConfig)
     for (int i = 0; i < 4; ++i)
     {
         symbols[i] = nr.NextSymbol();
-        BOOST_TEST_REQUIRE(symbols[i].c_str());
+        BOOST_TEST_REQUIRE(!symbols[i].empty());
     }
-    BOOST_TEST(!nr.NextSymbol());
+    BOOST_TEST(nr.NextSymbol().empty());
 
     sort(symbols, symbols+4);
     BOOST_TEST(boost::core::demangle(symbols[0].c_str()) == "test_function2()");
@@ -218,6 +392,26 @@ BOOST_FIXTURE_TEST_CASE(NMReaderTest, SampleLibConfig)
 
 }
 
+BOOST_FIXTURE_TEST_CASE(SymbolPipelineTest, SampleLibConfig)
+{
+    // one symbol per batch, so batches are demangled out of order
+    PipeReader pipe("nm -o " + sample_lib);
+    NMSymbolReader nr(&pipe);
+    SymbolAliasMap symmap;
+    BindStats stats;
+    SymbolPipeline(symmap, 3, 1, &stats).Run(nr);
+    BOOST_TEST(stats.symbols == 4);
+
+    // reading a directory fails in the reader thread
+    FILE *dir = fopen(".", "r");
+    BOOST_TEST_REQUIRE(dir);
+    Reader reader(dir);
+    NMSymbolReader dir_nr(&reader);
+    BOOST_CHECK_THROW(SymbolPipeline(symmap, 3, 1).Run(dir_nr),
+        runtime_error);
+    fclose(dir);
+}
+
 BOOST_AUTO_TEST_CASE(FindWrappedSymbolTest)
 {
     WrapperBase::Prototypes protos;
@@ -257,3 +451,515 @@ BOOST_AUTO_TEST_CASE(FindWrappedSymbolTest)
             (a != sm.Map().end() && a->second == "symbol_for_alias" + no));
     }
 }
+
+BOOST_AUTO_TEST_CASE(SymbolAliasMapMergeTest)
+{
+    WrapperBase::Prototypes protos;
+    protos.insert(make_pair("test_function2", FunctionPrototype("int", "test_function2", "()",
+        internal::Qualifiers::NO_QUAL, "alias1")));
+    protos.insert(make_pair("test_function", FunctionPrototype("int", "test_function", "()",
+        internal::Qualifiers::NO_QUAL, "alias2")));
+
+    ostringstream log;
+    SymbolAliasMap first, second;
+    first.SetLog(log);
+    second.SetLog(log);
+    first.FindWrappedSymbol(protos, "test_function2()", "first_symbol1");
+    second.FindWrappedSymbol(protos, "test_function2()", "second_symbol1");
+    second.FindWrappedSymbol(protos, "test_function()", "second_symbol2");
+
+    first.Merge(second, "libsecond.so");
+    BOOST_TEST(first.Map().size() == 2);
+    BOOST_TEST(first.Map().at("alias1") == "first_symbol1");
+    BOOST_TEST(first.Map().at("alias2") == "second_symbol2");
+    BOOST_TEST(log.str().find("Ignoring symbol second_symbol1 of "
+        "libsecond.so") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(SymbolAliasMapMergeClonesTest)
+{
+    WrapperBase::Prototypes protos;
+    protos.insert(make_pair("test_function2", FunctionPrototype("int", "test_function2", "()",
+        internal::Qualifiers::NO_QUAL, "alias1")));
+    protos.insert(make_pair("test_function", FunctionPrototype("int", "test_function", "()",
+        internal::Qualifiers::NO_QUAL, "alias2")));
+
+    ostringstream log;
+    SymbolAliasMap first, second;
+    first.SetLog(log);
+    second.SetLog(log);
+    first.FindWrappedSymbol(protos, "test_function2()", "_Z14test_function2v");
+    // the second library only has a clone of test_function2()
+    second.FindWrappedSymbol(protos, "test_function2() [clone .isra.0]",
+        "_Z14test_function2v.isra.0");
+    // and its own test_function(), which is ignored with its clone
+    first.FindWrappedSymbol(protos, "test_function()", "first_symbol2");
+    second.FindWrappedSymbol(protos, "test_function()", "second_symbol2");
+    second.FindWrappedSymbol(protos, "test_function() [clone .part.0]",
+        "second_symbol2.part.0");
+
+    first.Merge(second, "libsecond.a");
+    BOOST_TEST(first.Map().at("alias1") == "_Z14test_function2v");
+    BOOST_TEST_REQUIRE(first.Clones().size() == 1);
+    BOOST_TEST((first.Clones().at("alias1")
+        == vector<string> { "_Z14test_function2v.isra.0" }));
+}
+
+BOOST_AUTO_TEST_CASE(FindWrappedCloneTest)
+{
+    WrapperBase::Prototypes protos;
+    protos.insert(make_pair("test_function2", FunctionPrototype("int", "test_function2", "()",
+        internal::Qualifiers::NO_QUAL, "alias1")));
+    protos.insert(make_pair("test_function", FunctionPrototype("int", "test_function", "()",
+        internal::Qualifiers::NO_QUAL, "alias2")));
+
+    BOOST_TEST(SymbolAliasMap::CloneSuffixPos("_Z14test_function2v.isra.0") == 19);
+    BOOST_TEST(SymbolAliasMap::CloneSuffixPos("folan.part.0.cold") == 5);
+    BOOST_TEST(SymbolAliasMap::CloneSuffixPos("folan.parts") == string::npos);
+    BOOST_TEST(SymbolAliasMap::CloneSuffixPos("_Z5folanv") == string::npos);
+    BOOST_TEST(SymbolAliasMap::FunctionName("test_function.constprop.0")
+        == "test_function");
+
+    ostringstream log;
+    SymbolAliasMap sm;
+    sm.SetLog(log);
+    sm.FindWrappedSymbol(protos, "test_function2()", "_Z14test_function2v");
+    sm.FindWrappedSymbol(protos, "test_function2() [clone .isra.0]",
+        "_Z14test_function2v.isra.0");
+    // cold parts are not entry points
+    sm.FindWrappedSymbol(protos, "test_function2() [clone .cold]",
+        "_Z14test_function2v.cold");
+    sm.FindWrappedSymbol(protos, "test_function.constprop.0",
+        "test_function.constprop.0");
+
+    BOOST_TEST(sm.Map().at("alias1") == "_Z14test_function2v");
+    BOOST_TEST(sm.Map().count("alias2") == 0);
+    BOOST_TEST_REQUIRE(sm.Clones().size() == 2);
+    BOOST_TEST((sm.Clones().at("alias1")
+        == vector<string> { "_Z14test_function2v.isra.0" }));
+    BOOST_TEST((sm.Clones().at("alias2")
+        == vector<string> { "test_function.constprop.0" }));
+}
+
+BOOST_AUTO_TEST_CASE(MangledNameFilterTest)
+{
+    BOOST_TEST(MangledNameFilter::BaseIdentifier("A::folani") == "folani");
+    BOOST_TEST(MangledNameFilter::BaseIdentifier("folan<char>") == "folan");
+    BOOST_TEST(MangledNameFilter::BaseIdentifier("N::B<int>::f2<A::B>")
+        == "f2");
+    BOOST_TEST(MangledNameFilter::BaseIdentifier("A::operator<") == "operator");
+    BOOST_TEST(MangledNameFilter::BaseIdentifier("A::operatorx") == "operatorx");
+
+    MangledNameFilter filter;
+    filter.AddPrototype(FunctionPrototype("char", "folan<char>", "(int)",
+        internal::Qualifiers::NO_QUAL, "alias1"));
+    filter.AddPrototype(FunctionPrototype("int", "test_function", "()",
+        internal::Qualifiers::NO_QUAL, "alias2"));
+    filter.AddPrototype(FunctionPrototype("void", "A::folani", "(int)",
+        internal::Qualifiers::NO_QUAL, "alias3"));
+    filter.AddPrototype(FunctionPrototype("void", "N::get1", "(int)",
+        internal::Qualifiers::NO_QUAL, "alias4"));
+
+    BOOST_TEST(filter.MayMatch("_Z5folanIcEci"));
+    BOOST_TEST(filter.MayMatch("test_function"));
+    BOOST_TEST(filter.MayMatch("_ZN1A6folaniEi"));
+    BOOST_TEST(filter.MayMatch("_ZN1A6folaniB5cxx11Ei"));
+    BOOST_TEST(filter.MayMatch("_ZN1N4get1Ei"));
+    BOOST_TEST(filter.MayMatch("_ZN1A6folaniEi.isra.0"));
+    BOOST_TEST(!filter.MayMatch("_Z14test_function2v"));
+    BOOST_TEST(!filter.MayMatch("test_function2"));
+    BOOST_TEST(!filter.MayMatch("_ZN1A7folani2Ei"));
+    BOOST_TEST(filter.MayMatch("test_function.part.0"));
+    BOOST_TEST(!filter.MayMatch("_ZNSt6vectorIiSaIiEE9push_backERKi"));
+
+    filter.AddPrototype(FunctionPrototype("bool", "A::operator==",
+        "(A const&)", internal::Qualifiers::CONST, "alias5"));
+    BOOST_TEST(filter.MayMatch("_ZNK1AeqERKS_"));
+    BOOST_TEST(!filter.MayMatch("test_function2"));
+}
+
+BOOST_FIXTURE_TEST_CASE(SymbolRenamerTest, SampleLibConfig)
+{
+    const string renamed_lib = sample_lib + ".renamed.a";
+    WriteFileAtomically(renamed_lib, ReadFile(sample_lib));
+    BOOST_TEST_REQUIRE(SymbolRenamer::IsSupported(renamed_lib));
+
+    SymbolRenamer renamer({ { "test_function", "renamed_test_function" },
+        { "_Z14test_function2v", "_Z22renamed_test_function2v" } });
+    BOOST_TEST(renamer.RenameFile(renamed_lib) == 2);
+    // nothing left to rename
+    BOOST_TEST(renamer.RenameFile(renamed_lib) == 0);
+
+    ArchiveFile archive(ReadFile(renamed_lib));
+    vector<string> symbols;
+    for (const auto &member: archive.Members())
+    {
+        if (member.special)
+            continue;
+        BOOST_TEST(member.name == "sample.cpp.o");
+        for (const auto &sym: ElfFile(string(member.Contents())).Symbols())
+            symbols.push_back(string(sym.name));
+    }
+    BOOST_TEST((find(symbols.begin(), symbols.end(), "renamed_test_function")
+        != symbols.end()));
+    BOOST_TEST((find(symbols.begin(), symbols.end(), "test_function")
+        == symbols.end()));
+
+    // check the result using nm, including the archive symbol index
+    PipeReader pipe("nm -s " + renamed_lib);
+    int found = 0;
+    string_view l;
+    while ((l = pipe.ReadLine()).data())
+    {
+        if (l.find("renamed_test_function") != string::npos)
+            ++found;
+        BOOST_TEST(l.find(" test_function") == string::npos);
+    }
+    BOOST_TEST(found == 4);
+    remove(renamed_lib.c_str());
+}
+
+BOOST_FIXTURE_TEST_CASE(SymbolRenamerCopyTest, SampleLibConfig)
+{
+    const string output_dir = sample_lib + ".copies";
+    const uint64_t lib_hash = FileHash(sample_lib);
+    const string lib_name = sample_lib.substr(sample_lib.rfind('/') + 1);
+
+    SymbolRenamer renamer(ElfFile::RenameMap { { "test_function",
+        "renamed_test_function" } });
+    auto copies = renamer.CopyRenamed(sample_lib, output_dir);
+    BOOST_TEST_REQUIRE(copies.size() == 1);
+    BOOST_TEST(copies[0] == output_dir + '/' + lib_name + "/sample.cpp.o");
+    // the library itself is not modified
+    BOOST_TEST(FileHash(sample_lib) == lib_hash);
+
+    vector<string> symbols;
+    for (const auto &sym: ElfFile(ReadFile(copies[0])).Symbols())
+        symbols.push_back(string(sym.name));
+    BOOST_TEST((find(symbols.begin(), symbols.end(), "renamed_test_function")
+        != symbols.end()));
+    BOOST_TEST((find(symbols.begin(), symbols.end(), "test_function")
+        == symbols.end()));
+
+    // unchanged copies are not rewritten
+    BOOST_TEST(!WriteFileIfChanged(copies[0], ReadFile(copies[0])));
+    BOOST_TEST(renamer.CopyRenamed(sample_lib, output_dir) == copies);
+
+    // nothing to rename, nothing to copy
+    BOOST_TEST(SymbolRenamer(ElfFile::RenameMap { { "no_such_symbol", "x" } })
+        .CopyRenamed(sample_lib, output_dir).empty());
+    remove(copies[0].c_str());
+    remove((output_dir + '/' + lib_name).c_str());
+    remove(output_dir.c_str());
+}
+
+BOOST_FIXTURE_TEST_CASE(CallSiteAnalysisTest, SampleLibConfig)
+{
+    CallSiteAnalysis analysis({ { "alias1", "_Z14test_function2v" },
+        { "alias2", "_Z5folanIcET_i" } });
+    BOOST_TEST(analysis.AddFile(sample_lib));
+
+    const auto &func = analysis.Symbols().at("_Z14test_function2v");
+    BOOST_TEST(func.global_defs == 1);
+    BOOST_TEST(func.weak_defs == 0);
+    BOOST_TEST(func.wrapped_refs + func.unwrapped_refs == 0);
+    // explicit template instances are weak
+    const auto &tpl = analysis.Symbols().at("_Z5folanIcET_i");
+    BOOST_TEST(tpl.global_defs == 0);
+    BOOST_TEST(tpl.weak_defs == 1);
+
+    ostringstream report;
+    analysis.Report(report);
+    BOOST_TEST(report.str().find("Call sites of test_function2(): 0 wrapped, "
+        "0 not wrapped") != string::npos);
+    BOOST_TEST(report.str().find("No references found") != string::npos);
+
+    // wrapper objects call the real functions through undefined symbols
+    ArchiveFile wrap_lib(ReadFile(sample_wrap_lib));
+    set<string> undefined_calls;
+    for (const auto &member: wrap_lib.Members())
+        if (!member.special)
+            for (const auto &ref: ElfFile(string(member.Contents()))
+                    .References())
+                if (!ref.defined && ref.from_code && ref.symbol.find(
+                        "__real_function_") != string_view::npos)
+                    undefined_calls.insert(string(ref.symbol));
+    BOOST_TEST(undefined_calls.size() == 5);
+}
+
+BOOST_FIXTURE_TEST_CASE(CallSiteAnalysisUnreferencedTest, SampleLibConfig)
+{
+    const map<string, string> symbols = { { "alias1", "_Z14test_function2v" } };
+    CallSiteAnalysis analysis(symbols);
+    BOOST_TEST(analysis.AddFile(sample_lib));
+    BOOST_TEST(analysis.Unreferenced().count("_Z14test_function2v") == 1);
+
+    // referenced only from another object, like the test binary objects
+    // given by --ref-object, so it is not pruned
+    BOOST_TEST(analysis.AddFile(sample_wrap_lib));
+    BOOST_TEST(analysis.Unreferenced().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(CallSiteAnalysisDefinedRefsTest, SampleLibConfig)
+{
+    // boost::core::demangle() is defined & called in the wrapper object
+    const string symbol = "_ZN5boost4core8demangleB5cxx11EPKc";
+    const map<string, string> symbols = { { "alias1", symbol } };
+    CallSiteAnalysis analysis(symbols);
+    BOOST_TEST(analysis.AddFile(sample_wrap_lib));
+    BOOST_TEST(analysis.Symbols().at(symbol).wrapped_refs == 0);
+    BOOST_TEST(analysis.Symbols().at(symbol).unwrapped_refs > 0);
+}
+
+BOOST_AUTO_TEST_CASE(WrapperShardsTest)
+{
+    istringstream list("// comment\n#include \"functions.h\"\n\n"
+        "WRAP_FUNCTION(normal_func);\n"
+        "WRAP_FUNCTION(void (int),\n    overloaded)\n"
+        "using namespace FakeTest;\n"
+        "WRAP_STATIC_MEMBER(SampleClass, SampleClass::StaticFunc);\n");
+    WrapperShards shards;
+    shards.Read(list);
+    BOOST_TEST(shards.Preamble() == vector<string>({ "#include \"functions.h\"",
+        "using namespace FakeTest;" }), boost::test_tools::per_element());
+    BOOST_TEST_REQUIRE(shards.Wrappers().size() == 3);
+    BOOST_TEST(shards.Wrappers()[1] == "WRAP_FUNCTION(void (int), overloaded);");
+
+    auto sources = shards.Sources(2, "Shard");
+    BOOST_TEST_REQUIRE(sources.size() == 2);
+    size_t found = 0;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        BOOST_TEST(sources[i].find("#include \"functions.h\"\nusing namespace "
+            "FakeTest;\n") != string::npos);
+        BOOST_TEST(sources[i].find("#define POWRFAKE_WRAP_NAMESPACE Shard"
+            + to_string(i) + '\n') != string::npos);
+        for (const auto &wrapper: shards.Wrappers())
+            if (sources[i].find(wrapper) != string::npos)
+                ++found;
+    }
+    BOOST_TEST(found == 3);
+    // sources are deterministic, so unchanged ones are not recompiled
+    BOOST_TEST(sources == shards.Sources(2, "Shard"),
+        boost::test_tools::per_element());
+
+    istringstream incomplete("WRAP_FUNCTION(void (int),\n");
+    BOOST_CHECK_THROW(WrapperShards().Read(incomplete), runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(WriteFileIfChangedTest, SampleLibConfig)
+{
+    const string file = sample_lib + ".flags";
+    remove(file.c_str());
+
+    BOOST_TEST(WriteFileIfChanged(file, "-Wl,--wrap=folan\n"));
+    BOOST_TEST(!WriteFileIfChanged(file, "-Wl,--wrap=folan\n"));
+    BOOST_TEST(WriteFileIfChanged(file, ""));
+    BOOST_TEST(!WriteFileIfChanged(file, ""));
+    BOOST_TEST(ReadFile(file).empty());
+    remove(file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(CreateDirectoriesTest)
+{
+    // a relative path with a single character first component
+    CreateDirectories("o/x");
+    struct stat st;
+    BOOST_TEST(stat("o/x", &st) == 0);
+    BOOST_TEST(S_ISDIR(st.st_mode));
+    // existing directories are fine
+    CreateDirectories("o/x/");
+    BOOST_TEST(rmdir("o/x") == 0);
+    BOOST_TEST(rmdir("o") == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(BindCacheTest, SampleLibConfig)
+{
+    const string cache_file = sample_lib + ".cache";
+    BindCache cache;
+    cache.key = BindCache::Key { "objcopy=1", 10, 20 };
+    cache.symbol_map["alias1"] = "_Z5folanIcEci";
+    cache.link_flags = "-Wl,--wrap=_Z5folanIcEci\n";
+    cache.objects.push_back(BindCache::ObjectEntry { "wrap lib.a", 1, 2,
+        { { "_Z3tmpv", "__wrap__Z5folanIcEci" } } });
+    cache.Save(cache_file);
+
+    BindCache loaded;
+    BOOST_TEST_REQUIRE(loaded.Load(cache_file));
+    BOOST_TEST((loaded.key == cache.key));
+    BOOST_TEST((loaded.symbol_map == cache.symbol_map));
+    BOOST_TEST(loaded.link_flags == cache.link_flags);
+    BOOST_TEST_REQUIRE(loaded.objects.size() == 1);
+    BOOST_TEST(loaded.objects[0].file_name == "wrap lib.a");
+    BOOST_TEST((loaded.objects[0].renames == cache.objects[0].renames));
+
+    // both unprocessed and processed wrapper objects match
+    BOOST_TEST(loaded.Matches(cache.key, { "wrap lib.a" }, { 1 }));
+    BOOST_TEST(loaded.Matches(cache.key, { "wrap lib.a" }, { 2 }));
+    BOOST_TEST(!loaded.Matches(cache.key, { "wrap lib.a" }, { 3 }));
+    BOOST_TEST(!loaded.Matches(BindCache::Key { "objcopy=1", 11, 20 },
+        { "wrap lib.a" }, { 1 }));
+    remove(cache_file.c_str());
+}
+
+BOOST_FIXTURE_TEST_CASE(SymbolIndexTest, SampleLibConfig)
+{
+    const string index_file = sample_lib + ".test_index";
+    remove(index_file.c_str());
+
+    auto result = SymbolIndex::Update(index_file, sample_lib);
+    BOOST_TEST(result.scanned_members == 1);
+    BOOST_TEST(result.reused_members == 0);
+    BOOST_TEST(result.written);
+
+    // nothing changed, index is reused as is
+    result = SymbolIndex::Update(index_file, sample_lib);
+    BOOST_TEST(result.scanned_members == 0);
+    BOOST_TEST(result.reused_members == 1);
+    BOOST_TEST(!result.written);
+
+    // a touched library is read again, but its members are reused
+    const string lib_copy = sample_lib + ".test_copy";
+    const string copy_index = index_file + ".copy";
+    remove(copy_index.c_str());
+    WriteFileAtomically(lib_copy, ReadFile(sample_lib));
+    BOOST_TEST(SymbolIndex::Update(copy_index, lib_copy).written);
+    struct timespec times[2] = { { 1, 0 }, { 1, 0 } };
+    BOOST_TEST_REQUIRE(utimensat(AT_FDCWD, lib_copy.c_str(), times, 0) == 0);
+    result = SymbolIndex::Update(copy_index, lib_copy);
+    BOOST_TEST(result.scanned_members == 0);
+    BOOST_TEST(result.reused_members == 1);
+    // the new time stamp is recorded
+    BOOST_TEST(result.written);
+    BOOST_TEST(!SymbolIndex::Update(copy_index, lib_copy).written);
+    remove(lib_copy.c_str());
+    remove(copy_index.c_str());
+
+    SymbolIndex index;
+    BOOST_TEST_REQUIRE(index.Open(index_file));
+    BOOST_TEST(index.MemberCount() == 1);
+    BOOST_TEST(index.MemberName(0) == "sample.cpp.o");
+
+    auto range = index.Find("folan<char>");
+    BOOST_TEST_REQUIRE(range.second - range.first == 1);
+    auto entry = index.At(range.first);
+    BOOST_TEST(entry.demangled == "char folan<char>(int)");
+    BOOST_TEST(entry.mangled == "_Z5folanIcET_i");
+
+    range = index.Find("folani");
+    BOOST_TEST_REQUIRE(range.second - range.first == 1);
+    BOOST_TEST(index.At(range.first).demangled == "A::folani(int)");
+
+    range = index.Find("test_function");
+    BOOST_TEST_REQUIRE(range.second - range.first == 1);
+    BOOST_TEST(index.At(range.first).mangled == "test_function");
+
+    range = index.Find("non_existent");
+    BOOST_TEST(range.first == range.second);
+
+    // index is sorted by key
+    for (size_t i = 1; i < index.Size(); ++i)
+        BOOST_TEST((index.At(i - 1).key <= index.At(i).key));
+    remove(index_file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BindStatsTest)
+{
+    BindStats stats;
+    {
+        BindStats::ScopedPhase phase(&stats, BindStats::READ, 10);
+    }
+    BindStats::ScopedPhase(nullptr, BindStats::MATCH, 5);
+    BindStats::Timer timer;
+    timer.Start();
+    timer.Stop();
+    stats.Add(BindStats::READ, timer, 2);
+    stats.symbols = 12;
+    ++stats.processes;
+
+    BOOST_TEST(stats.Get(BindStats::READ).items == 12);
+    BOOST_TEST(stats.Get(BindStats::READ).wall >= 0);
+    BOOST_TEST(stats.Get(BindStats::MATCH).items == 0);
+
+    ostringstream json;
+    stats.WriteJson(json);
+    BOOST_TEST(json.str().find("\"read\": { \"wall\": ") != string::npos);
+    BOOST_TEST(json.str().find("\"items\": 12 }") != string::npos);
+    BOOST_TEST(json.str().find("\"symbols\": 12,") != string::npos);
+    BOOST_TEST(json.str().find("\"processes\": 1\n}") != string::npos);
+
+    ostringstream report;
+    stats.Report(report);
+    BOOST_TEST(report.str().find("spawned processes: 1") != string::npos);
+}
+
+BOOST_FIXTURE_TEST_CASE(PrototypeManifestTest, SampleLibConfig)
+{
+    const string manifest_file = sample_lib + ".test_manifest";
+    WrapperBase::Prototypes protos;
+    protos.insert(make_pair("folan", FunctionPrototype("char", "folan<char>",
+        "(int)", 0, "alias_1")));
+    protos.insert(make_pair("folani", FunctionPrototype("int", "A::folani",
+        "(std::vector<int, std::allocator<int> > const&)",
+        Qualifiers::CONST, "alias_2")));
+
+    PrototypeManifest::Write(manifest_file, protos);
+    auto read = PrototypeManifest::Read(manifest_file);
+    BOOST_TEST_REQUIRE(read.size() == 2);
+    BOOST_TEST(read[0].alias == "alias_1");
+    BOOST_TEST(read[0].Str() == protos.find("folan")->second.Str());
+    BOOST_TEST(read[1].alias == "alias_2");
+    BOOST_TEST(read[1].Str() == protos.find("folani")->second.Str());
+
+    ofstream(manifest_file) << "powerfake-manifest 1\nproto broken\n";
+    BOOST_CHECK_THROW(PrototypeManifest::Read(manifest_file), runtime_error);
+    remove(manifest_file.c_str());
+    BOOST_CHECK_THROW(PrototypeManifest::Read(manifest_file), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(SplitFunctionTypeTest)
+{
+    string ret, cls, params;
+    BOOST_TEST(PrototypeNotes::SplitFunctionType("void (*)(int)", ret, cls,
+        params));
+    BOOST_TEST(ret == "void");
+    BOOST_TEST(cls.empty());
+    BOOST_TEST(params == "(int)");
+
+    BOOST_TEST(PrototypeNotes::SplitFunctionType("std::map<int, char (*)(int), "
+        "std::less<int> > const& (A::B<char>::*)(char const*, int)", ret, cls,
+        params));
+    BOOST_TEST(ret == "std::map<int, char (*)(int), std::less<int> >");
+    BOOST_TEST(cls == "A::B<char>");
+    BOOST_TEST(params == "(char const*, int)");
+
+    BOOST_TEST(PrototypeNotes::SplitFunctionType("char const* (*)()", ret, cls,
+        params));
+    BOOST_TEST(ret == "char const*");
+
+    BOOST_TEST(!PrototypeNotes::SplitFunctionType("int", ret, cls, params));
+}
+
+BOOST_FIXTURE_TEST_CASE(PrototypeNotesTest, SampleLibConfig)
+{
+    auto protos = PrototypeNotes::Read(sample_wrap_lib);
+    BOOST_TEST_REQUIRE(protos.size() == 5);
+
+    map<string, FunctionPrototype> by_name;
+    for (const auto &p: protos)
+    {
+        BOOST_TEST(p.alias.find("PowerFakeWrap_alias_") == 0);
+        by_name.insert(make_pair(p.name, p));
+    }
+    BOOST_TEST(by_name.at("test_function2").Str() == "int test_function2() ");
+    BOOST_TEST(by_name.at("folan<char>").Str() == "char folan<char>(int) ");
+    BOOST_TEST(by_name.at("B::Name").Str() == "std::__cxx11::basic_string<char,"
+        " std::char_traits<char>, std::allocator<char> > B::Name() const");
+    BOOST_TEST(by_name.at("B::Count").Str() == "int B::Count(long) ");
+    // wrapped inside a namespace
+    BOOST_TEST(by_name.at("wrapped::ns_function").Str()
+        == "int wrapped::ns_function(int) ");
+
+    // objects without prototype notes
+    BOOST_TEST(PrototypeNotes::Read(sample_lib).empty());
+}
@@ -0,0 +1,35 @@
+/*
+ *  Copyright Hedayat Vatankhah 2026.
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *     (See accompanying file LICENSE_1_0.txt or copy at
+ *           http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include <string>
+#include <powerfake.h>
+
+int test_function2();
+
+template<typename T>
+T folan(int b);
+
+class B {
+    public:
+        const std::string &Name() const;
+        static int Count(long);
+};
+
+WRAP_FUNCTION(test_function2);
+WRAP_FUNCTION(folan<char>);
+WRAP_FUNCTION(B::Name);
+WRAP_STATIC_MEMBER(B, B::Count);
+
+namespace wrapped
+{
+
+int ns_function(int a);
+
+WRAP_FUNCTION(wrapped::ns_function);
+
+}
@@ -10,10 +10,23 @@
  *           http://www.boost.org/LICENSE_1_0.txt)
  */
 
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Define the test module. It must be defined before including unit_test.hpp
 #define BOOST_TEST_MODULE RFlowManagerTester
+// main() is defined below, to support fork mode
+#define BOOST_TEST_NO_MAIN
 
 /* Including this header will include all needed Boost.Test sources so that
  * there is no need to link with any libraries. But it makes compilation of
@@ -24,6 +37,20 @@
 // Include the following header instead of the above if you link with compiled
 // boost_test library
 #include <boost/test/unit_test.hpp>
+#include <boost/cstdlib.hpp>
+#include <boost/test/results_collector.hpp>
+#include <boost/test/results_reporter.hpp>
+#include <boost/test/tree/traverse.hpp>
+#include <boost/test/unit_test_parameters.hpp>
+#include <boost/version.hpp>
+
+/* Fork mode selects the tests of each child through Boost.Test internals
+ * (framework::impl::setup_for_execution() and the run_test entry of the
+ * runtime argument store), which are only tested with Boost 1.74 and newer.
+ */
+#if BOOST_VERSION >= 107400
+#define POWERFAKE_FORK_MODE
+#endif
 
 // Disable buffering for stdout, specially useful for XML output
 // This is needed to get progress bar in Eclipse
@@ -34,3 +61,231 @@ static struct DisableStdCoutBuffering
             std::cout.setf(std::ios_base::unitbuf);
         }
 } s_disableStdCoutBuffering;
+
+namespace
+{
+
+namespace ut = boost::unit_test;
+
+#ifdef POWERFAKE_FORK_MODE
+/**
+ * Collects full names of enabled test cases
+ */
+class EnabledTestCases: public ut::test_tree_visitor
+{
+    public:
+        void visit(const ut::test_case &tc) override
+        {
+            names.push_back(tc.full_name());
+        }
+
+        std::vector<std::string> names;
+};
+
+/**
+ * A forked child running a shard of test cases, whose output is kept in a
+ * temporary file until it finishes, so that outputs of concurrent children
+ * are not mixed
+ */
+struct ForkedShard
+{
+    const std::vector<std::string> *tests;
+    FILE *output;
+};
+
+/**
+ * Runs only @p tests in a forked child; the framework is already initialized
+ * by the parent
+ * @return the result code of the tests
+ */
+int RunForkedTests(const std::vector<std::string> &tests)
+{
+    // tests are selected the same way as --run_test, which also runs their
+    // dependencies. The store is returned as const, but it is a modifiable
+    // static object of Boost.Test.
+    auto &args = const_cast<boost::runtime::arguments_store &>(
+        ut::runtime_config::argument_store());
+    args.set(ut::runtime_config::btrt_run_filters, tests);
+
+    ut::framework::run();
+    ut::results_reporter::make_report();
+    int result = ut::results_collector.results(
+        ut::framework::master_test_suite().p_id).result_code();
+    ut::framework::shutdown();
+    return result;
+}
+
+/**
+ * Waits for one of @p running children to finish, and prints its output
+ * @return true if the child succeeded
+ */
+bool ReapShard(std::map<pid_t, ForkedShard> &running)
+{
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, 0)) < 0 && errno == EINTR)
+        ;
+    auto child = running.find(pid);
+    if (child == running.end())
+        throw std::runtime_error(std::string("waitpid() failed: ")
+            + strerror(errno));
+    ForkedShard shard = child->second;
+    running.erase(child);
+
+    rewind(shard.output);
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), shard.output)) > 0)
+        std::cout.write(buf, len);
+    fclose(shard.output);
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        return true;
+    std::cout << "*** Failed test process (";
+    if (WIFSIGNALED(status))
+        std::cout << "signal " << WTERMSIG(status);
+    else
+        std::cout << "exit code " << WEXITSTATUS(status);
+    std::cout << "):";
+    for (const auto &t: *shard.tests)
+        std::cout << ' ' << t;
+    std::cout << std::endl;
+    return false;
+}
+
+/**
+ * Fork mode: static initialization and test tree setup are done once, and
+ * each test case (or shard of test cases) is run in a forked child, so that
+ * each of them starts with a clean state (e.g. no global fakes are left by
+ * other tests) without paying the start up cost of a new process. Children
+ * run concurrently, at most as many as online CPUs.
+ * @param shards number of processes, or 0 to fork a child for each test case
+ * @return boost::exit_success if all children succeed
+ */
+int ForkedMain(int argc, char *argv[], size_t shards)
+{
+    EnabledTestCases enabled;
+    try
+    {
+        ut::framework::init(&init_unit_test, argc, argv);
+        ut::framework::finalize_setup_phase();
+        // apply --run_test filters
+        ut::framework::impl::setup_for_execution(
+            ut::framework::master_test_suite());
+        ut::traverse_test_tree(ut::framework::master_test_suite(), enabled);
+    }
+    catch (ut::framework::nothing_to_test &e)
+    {
+        return e.m_result_code;
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << "Test setup error: " << e.what() << std::endl;
+        return boost::exit_exception_failure;
+    }
+
+    if (shards == 0 || shards > enabled.names.size())
+        shards = enabled.names.size();
+    std::vector<std::vector<std::string>> shard_tests(shards);
+    for (size_t i = 0; i < enabled.names.size(); ++i)
+        shard_tests[i % shards].push_back(enabled.names[i]);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_running = cpus > 0 ? cpus : 1;
+    std::map<pid_t, ForkedShard> running;
+    size_t failed = 0;
+    try
+    {
+        for (const auto &tests: shard_tests)
+        {
+            if (running.size() >= max_running && !ReapShard(running))
+                ++failed;
+
+            FILE *output = tmpfile();
+            if (!output)
+                throw std::runtime_error(std::string("tmpfile() failed: ")
+                    + strerror(errno));
+            std::cout.flush();
+            std::cerr.flush();
+            pid_t pid = fork();
+            if (pid < 0)
+            {
+                fclose(output);
+                throw std::runtime_error(std::string("fork() failed: ")
+                    + strerror(errno));
+            }
+            if (pid == 0)
+            {
+                dup2(fileno(output), STDOUT_FILENO);
+                dup2(fileno(output), STDERR_FILENO);
+                std::exit(RunForkedTests(tests));
+            }
+            running.emplace(pid, ForkedShard { &tests, output });
+        }
+        while (!running.empty())
+            if (!ReapShard(running))
+                ++failed;
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        while (wait(nullptr) > 0 || errno == EINTR)
+            ;
+        for (auto &child: running)
+            fclose(child.second.output);
+        return boost::exit_exception_failure;
+    }
+    std::cout << "*** " << enabled.names.size() << " test cases in " << shards
+            << " forked processes, " << failed << " failed" << std::endl;
+    ut::framework::shutdown();
+    return failed ? boost::exit_test_failure : boost::exit_success;
+}
+#endif
+
+/**
+ * Parses the value of --fork=<shards>
+ * @return the number of shards, or 0 if @p value is not a positive number
+ */
+size_t ParseShards(const char *value)
+{
+    char *end;
+    errno = 0;
+    unsigned long shards = strtoul(value, &end, 10);
+    if (errno || end == value || *end || value[0] == '-')
+        return 0;
+    return shards;
+}
+
+}  // namespace
+
+/**
+ * Runs tests normally, or in fork mode if --fork (a child for each test case)
+ * or --fork=<shards> is given after "--", among test module arguments
+ */
+int main(int argc, char *argv[])
+{
+    bool module_args = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (argv[i] == std::string("--"))
+            module_args = true;
+        else if (module_args && (argv[i] == std::string("--fork")
+                || strncmp(argv[i], "--fork=", 7) == 0))
+        {
+            size_t shards = 0;
+            if (argv[i][6] == '=' && !(shards = ParseShards(argv[i] + 7)))
+            {
+                std::cerr << "Invalid number of shards: " << argv[i]
+                        << std::endl;
+                return boost::exit_exception_failure;
+            }
+#ifdef POWERFAKE_FORK_MODE
+            return ForkedMain(argc, argv, shards);
+#else
+            std::cerr << "Fork mode needs Boost 1.74 or newer" << std::endl;
+            return boost::exit_exception_failure;
+#endif
+        }
+    }
+    return ut::unit_test_main(&init_unit_test, argc, argv);
+}